@@ -0,0 +1,34 @@
+/*
+ Allocation auditing
+
+ Checks that the frame loop doesn't touch the heap once it has warmed up. Only built in
+ with DEFS=-DALLOC_AUDIT, which routes the game's malloc, calloc, realloc and free (and SDL's,
+ through SDL_SetMemoryFunctions) through counters. When turned on with --audit-alloc, every
+ frame after the warm-up that allocates is logged.
+ */
+
+// Frames which may allocate freely while caches and buffers fill up (two seconds)
+#define AUDIT_WARMUP (2 * MAX_FPS)
+
+#ifdef ALLOC_AUDIT
+#ifndef AUDIT_NO_REDIRECT
+// Counting wrappers for the standard allocation functions
+void* auditMalloc(size_t size);
+void* auditCalloc(size_t count, size_t size);
+void* auditRealloc(void* ptr, size_t size);
+void auditFree(void* ptr);
+#define malloc(size) auditMalloc(size)
+#define calloc(count, size) auditCalloc(count, size)
+#define realloc(ptr, size) auditRealloc(ptr, size)
+#define free(ptr) auditFree(ptr)
+#endif
+#endif
+
+// Start auditing allocations (before SDL is initialized), or return false if not built with ALLOC_AUDIT
+bool initAudit(void);
+
+// Check the allocations made since the last frame ended, logging them if the warm-up is over
+void auditFrame(void);
+
+// Print how many frames allocated after the warm-up
+void reportAudit(void);
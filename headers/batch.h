@@ -0,0 +1,30 @@
+/*
+ Batched rendering
+
+ Collects textured quads from one texture (e.g. the sprite sheet) into a vertex buffer,
+ and submits them all with a single SDL_RenderGeometry call instead of one
+ SDL_RenderCopyEx call each. Rotation and flipping are done on the CPU, matching
+ SDL_RenderCopyEx, and quads are drawn in the order they were added.
+
+ SDL_RenderGeometry needs SDL 2.0.18. With older SDL, or when batching is turned off,
+ every quad is drawn immediately with SDL_RenderCopyEx instead.
+ */
+
+// Most quads in a batch before it's submitted early (more can be added after that)
+#define BATCH_QUADS 4096
+
+// Turn batching on or off (it's on by default where SDL supports it)
+void setBatching(bool on);
+
+// Check whether quads are actually being batched
+bool isBatching(void);
+
+// Start a batch of quads from a texture
+void beginBatch(SDL_Texture* texture);
+
+// Add a quad to the batch, with the same meaning as SDL_RenderCopyEx with a NULL center
+// (rotated by angle degrees clockwise around the middle of dst, and flipped horizontally or not)
+void batchCopy(const SDL_Rect* clip, const SDL_Rect* dst, double angle, SDL_RendererFlip flip);
+
+// Submit the quads added since the batch began or was last flushed
+void flushBatch(void);
@@ -0,0 +1,103 @@
+/*
+ Broadphase collision detection
+
+ Given the bounding circles of a set of colliders, finds the pairs of colliders which
+ are close enough that they might be touching, so that only those pairs need a precise
+ collision check. Each candidate pair is reported exactly once. The grid and the sweep list
+ belong to the world whose colliders they hold (see world.h).
+
+ How a collision is handled depends on which of a sprite's collisions comes first, so
+ findPairs reports its candidates in the same order whichever method found them: by first
+ collider, then by second, as brute force does. The choice of method then only changes how
+ fast the game runs, never what happens in it.
+ */
+
+// Available broadphase methods
+enum broadphases
+{ BRUTE_FORCE, GRID, SWEEP };
+
+// Broadphase used unless another is chosen (can be overridden per build, e.g. make DEFS=-DDEFAULT_BROADPHASE=SWEEP).
+// A game only ever has a handful of colliders, which brute force gets through fastest
+#ifndef DEFAULT_BROADPHASE
+#define DEFAULT_BROADPHASE BRUTE_FORCE
+#endif
+
+// Region of the world where colliders can exist (sprites outside of it are unloaded)
+#define WORLD_LEFT -500
+#define WORLD_TOP -500
+#define WORLD_WIDTH (SCREEN_WIDTH + 1000)
+#define WORLD_HEIGHT (SCREEN_HEIGHT + 600)
+
+// Smallest cell size the grid will use, which bounds the number of cells
+#define MIN_CELL_SIZE 64
+#define GRID_MAX_COLS (WORLD_WIDTH / MIN_CELL_SIZE + 1)
+#define GRID_MAX_ROWS (WORLD_HEIGHT / MIN_CELL_SIZE + 1)
+#define GRID_MAX_CELLS (GRID_MAX_COLS * GRID_MAX_ROWS)
+
+// Struct for a uniform grid, bucketing colliders by the cell their center falls in. Only the cells
+// with colliders in them are ever visited, so a frame costs the same however many cells there are
+struct grid
+{
+    double cell_size;                   // width and height of a cell in pixels
+    int cols;                           // number of columns of cells in use
+    int rows;                           // number of rows of cells in use
+    int cell_of[MAX_SPRITES];           // which cell each collider is in
+    int num_occupied;                   // number of cells with colliders in them
+    int occupied[MAX_SPRITES];          // cells with colliders in them
+    int cell_count[GRID_MAX_CELLS];     // number of colliders in each cell (zeroed again after every frame)
+    int cell_start[GRID_MAX_CELLS];     // where each occupied cell's colliders begin in members
+    int members[MAX_SPRITES];           // colliders, grouped by cell
+};
+
+// Most candidate pairs held for putting in order in a frame (with more, findPairs checks every pair instead)
+#define MAX_CANDIDATE_PAIRS (4 * MAX_SPRITES)
+
+// Struct for the candidate pairs found in a frame, each stored as a * MAX_SPRITES + b with a < b,
+// so that sorting them puts them in the order brute force would report them in
+struct candidates
+{
+    int count;                          // number of candidate pairs found (may be more than are held)
+    int pairs[MAX_CANDIDATE_PAIRS];     // candidate pairs
+    int sorted[MAX_CANDIDATE_PAIRS];    // candidate pairs part way through being sorted
+    int starts[MAX_SPRITES + 1];        // where the pairs with each collider begin, while sorting
+};
+
+// Struct for an interval along the x axis covered by a collider, in the sweep list
+struct interval
+{
+    int key;                            // which collider this is, from frame to frame
+    int index;                          // which collider this is, in this frame's input
+    double min_x;                       // left edge of the collider's bounding circle
+    double max_x;                       // right edge of the collider's bounding circle
+};
+
+// Struct for the sweep and prune list, which persists between frames
+struct sweep
+{
+    int count;                          // number of intervals in the list
+    struct interval list[MAX_SPRITES];  // intervals, sorted by min_x as of the last sweep
+    int key_index[MAX_SPRITES];         // this frame's input index for each key (-1 if absent)
+    bool listed[MAX_SPRITES];           // whether each key is already in the list
+};
+
+// Choose which broadphase method findPairs uses
+void setBroadphase(int method);
+
+// Look up a broadphase method by name ("brute", "grid", "sweep"), returning -1 if there's no such method
+int broadphaseByName(const char* name);
+
+// Report every pair of the n colliders (centers x, y and radii r) which might overlap, using the chosen
+// broadphase, in order of first collider and then second. keys must identify the same collider from
+// frame to frame, and be in [0, MAX_SPRITES)
+void findPairs(World w, int n, const int* keys, const double* x, const double* y, const double* r, void (*on_pair)(World, int, int));
+
+// Report every pair of colliders, without any culling
+void findPairsBrute(World w, int n, void (*on_pair)(World, int, int));
+
+// Report every pair of colliders which might overlap, using a uniform grid of cells at least
+// as wide as the largest pair of radii
+void findPairsGrid(World w, int n, const double* x, const double* y, const double* r, void (*on_pair)(World, int, int));
+
+// Report every pair of colliders which might overlap, by sweeping along the x axis. The sorted
+// list of intervals is kept from the previous frame, so it only needs a cheap re-sort
+void findPairsSweep(World w, int n, const int* keys, const double* x, const double* y, const double* r, void (*on_pair)(World, int, int));
@@ -12,20 +12,29 @@
 #define SCREEN_WIDTH 1024
 #define SCREEN_HEIGHT 768
 
-// Frame rate constants
+// Frame rate constants (the simulation always ticks at MAX_FPS, however fast frames are rendered)
 #define ANIMATION_SPEED 1
 #define MAX_FPS 60
 
+// Most simulation ticks run before a frame is rendered, so a long stall doesn't snowball
+#define MAX_TICKS_PER_FRAME 5
+
+// Frames simulated in headless mode unless given on the command line (ten minutes of game time)
+#define HEADLESS_FRAMES (10 * 60 * MAX_FPS)
+
 // Cardinal directions
 enum directions
 { LEFT, RIGHT, UP, DOWN };
 
-// Get random number in [0, 1)
-static inline double get_rand() { return (double) rand() / (double) RAND_MAX; }
-
 // Convert (0,1) to (-1,1)
 static inline int convert(bool c) { return (c - (c == 0)); }
 
+// Interpolate between a previous value a and a current value b, alpha of the way from a to b
+static inline double lerp(double a, double b, double alpha) { return a + (b - a) * alpha; }
+
+// Everything that changes as a game is played, which the simulation functions are handed (see world.h)
+typedef struct world* World;
+
 // External constants initialized in main.c
 // Rendering, display, texture loading
 extern SDL_Window* window;
@@ -35,3 +44,10 @@ SDL_Texture* loadTexture(const char* path);
 // In debug mode, the framerate is lowered, the opening scene is skipped, there are no cooldowns,
 // music is muted, and sprite origins and bounding boxes are rendered
 extern bool debug;
+
+// In headless mode there is no window, renderer, audio, or textures, and the simulation runs
+// as fast as possible with the cpu controlling both guys
+extern bool headless;
+
+// Allocation auditing, which routes allocations through counters when built with ALLOC_AUDIT
+#include "audit.h"
@@ -0,0 +1,61 @@
+/*
+ Cpu players
+
+ Decides what a cpu guy does each tick. The classic cpu walks toward the other guy and casts
+ at random. The lookahead cpu tries out each thing it could do next (each spell, a jump,
+ walking either way, or waiting) by copying the world into a scratch world and simulating
+ it LOOKAHEAD_FRAMES ahead with the real physics and collisions, then does whichever turned
+ out best, give or take a little noise from the AI random stream so that its games vary
+ with the seed. The scratch world has no cosmetic particles, and the other guy is assumed
+ to stand still in it.
+
+ The classic cpu is the default, so tournaments and headless runs measure the game rather
+ than the lookahead's thinking. A lookahead mirror match on the volcano is lopsided: both
+ guys open with a rockfall, which lands dead center on a guy standing still, and a dead
+ center hit knocks its target to the left, off the left guy's ledge.
+
+ Only LOOKAHEAD_PER_TICK candidates are tried out each tick, so the cost of thinking is
+ spread evenly over ticks (a fraction of a millisecond per cpu guy) rather than landing on
+ the tick that decides. Once every candidate has been tried, the best is carried out while
+ the next round of thinking begins. How much is thought each tick is fixed, rather than
+ set by a clock, so the cpu decides the same way on every machine and replays stay exact.
+ */
+
+// Available cpu players
+enum cpu_players
+{ CPU_CLASSIC, CPU_LOOKAHEAD };
+
+// Cpu player used unless another is chosen (can be overridden per build, e.g. make DEFS=-DDEFAULT_CPU=CPU_LOOKAHEAD)
+#ifndef DEFAULT_CPU
+#define DEFAULT_CPU CPU_CLASSIC
+#endif
+
+// Things a lookahead cpu can do next (the spells come first, using the spell identities)
+enum cpu_actions
+{ CPU_JUMP = NUM_SPELLS, CPU_LEFT, CPU_RIGHT, CPU_WAIT, NUM_CPU_ACTIONS };
+
+// Frames each candidate is simulated ahead, frames a walk is held for in that time, and candidates tried per tick
+#define LOOKAHEAD_FRAMES 45
+#define LOOKAHEAD_WALK_FRAMES 15
+#define LOOKAHEAD_PER_TICK 3
+
+// Struct for what a lookahead cpu guy is thinking about and doing, which is part of the world
+// it's in (see world.h), so its decisions follow from the world alone
+struct cpu_plan
+{
+    int next_candidate;                 // candidate action to be tried out next
+    double scores[NUM_CPU_ACTIONS];     // how well each candidate did when last tried out
+    int action;                         // action being carried out
+};
+
+// Choose which cpu player takeCPUAction uses
+void setCPUPlayer(int player);
+
+// Get which cpu player takeCPUAction uses
+int getCPUPlayer(void);
+
+// Look up a cpu player by name, returning -1 if there's no such player
+int cpuByName(const char* name);
+
+// Process AI decisions for a cpu guy
+void takeCPUAction(World w, int cpu);
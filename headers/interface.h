@@ -9,6 +9,9 @@
 #define NUM_MENU_OPTIONS 5  // Total number of menu options (across all menus)
 #define FONT_SIZE 30        // Size in pixels of a letter
 
+#define TEXT_CACHE_SIZE 32  // Number of rendered strings kept in the text cache
+#define MAX_CACHED_TEXT 32  // Longest string the text cache holds (longer ones are drawn a letter at a time)
+
 // List of game states
 enum modes
 { OPENING, TITLE, CONTROLS, STAGE_SELECT, VS, AI, PAUSE, GAME_OVER_VS, GAME_OVER_AI };
@@ -24,14 +27,14 @@ enum text_align
 // Move the text selection arrow
 int hover(int mode, int direction);
 
-// Change the score
-void setScore(int new_score);
+// Render the parts of the given mode's interface that never change (drawn as part of the static layer)
+void renderChrome(int mode);
 
-// Add points to score
-void updateScore(int points);
+// Render all of the given mode's toolbar and text elements to the screen
+void renderInterface(int mode, long long frame, int shown_score, int guy_hp, int guy2_hp, const double* guy_cds, const double* guy2_cds);
 
-// Render all of the current mode's toolbar and text elements to the screen
-void renderInterface(int mode, long long frame, int guy_hp, int guy2_hp, double* guy_cds, double* guy2_cds);
+// Drop every rendered string from the text cache (e.g. after the renderer loses what was drawn into its target textures)
+void clearTextCache(void);
 
 // Load the toolbar texture, toolbar elements, and selection text into memory
 void loadInterface(void);
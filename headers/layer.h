@@ -0,0 +1,17 @@
+/*
+ Static layer compositing
+
+ Everything drawn each frame that never moves (the level's foreground and the outlines of
+ the interface's health bars) is composited once into a screen-sized texture, which is
+ drawn with a single copy. The layer is only rebuilt when the level or game mode changes.
+ Renderers that can't draw into textures get the pieces drawn separately every frame.
+ */
+
+// Draw the static layer for a level in a game mode, rebuilding it first if either has changed
+void renderStaticLayer(int level, int mode);
+
+// Rebuild the static layer the next time it's drawn (e.g. after the renderer loses its target textures)
+void invalidateStaticLayer(void);
+
+// Free the static layer's texture
+void freeStaticLayer(void);
@@ -13,26 +13,61 @@
 enum levels
 { FOREST, VOLCANO };
 
+// Struct for the state of a background, which drifts or scrolls as a world ticks (see world.h)
+struct background_state
+{
+    double x;                   // current x position
+    double y;                   // current y position
+    double prev_x;              // x position before the last tick, for interpolation
+    double prev_y;              // y position before the last tick, for interpolation
+    double x_vel;               // current x velocity
+    double y_vel;               // current y velocity
+};
+
+// Copy of everything needed to draw the current level, captured after a tick so that
+// rendering never reads the background while the simulation is moving it
+struct level_view
+{
+    int level;                  // which level is shown
+    double prev_x;              // background x position before the last tick
+    double prev_y;              // background y position before the last tick
+    double x;                   // background x position after the last tick
+    double y;                   // background y position after the last tick
+};
+
 // Switch the level to a new one
-void switchLevel(int new_level);
+void switchLevel(World w, int new_level);
+
+// Put every background of a world back where it starts
+void resetBackgrounds(World w);
 
 // Returns current level
-int getLevel(void);
+int getLevel(World w);
 
 // Return the platforms on the current foreground
-int* getPlatforms(void);
+int* getPlatforms(World w);
 
 // Return the walls on the current foreground
-int* getWalls(void);
+int* getWalls(World w);
 
 // Return the starting positions of both guys for the given foreground
 int* getStartingPositions(int fg);
 
 // Animate the background
-void moveBackground(void);
+void moveBackground(World w);
+
+// Capture everything needed to draw the current level
+void captureLevel(World w, struct level_view* view);
+
+// Render a captured level's background, alpha of the way from its previous to its current position
+void renderLevel(const struct level_view* view, double alpha);
+
+// Render a level's foreground
+void renderForeground(int level);
 
-// Render the current level
-void renderLevel(void);
+// Copy the foreground over whatever is under it, alpha and all, rather than blending it in (for drawing it
+// as the first thing in a texture that's blended when it's drawn)
+void copyForeground(int level);
 
 // Load all backgrounds and foregrounds
 void loadLevels(void);
@@ -0,0 +1,62 @@
+/*
+ Netplay
+
+ Plays a 2-player VS game between two copies of the game over UDP, with rollback. Each side
+ simulates every frame as soon as its own guy's input for it is known, predicting that the
+ other guy is still doing whatever he was last known to be doing. When the real input for
+ a frame arrives and turns out to differ from the prediction, the world is restored from a
+ snapshot taken just before that frame (see world.h) and every frame since is simulated
+ again, all within one tick. Since the simulation is deterministic, both sides end up in
+ the same world, which they check by trading world hashes every so often.
+
+ Inputs are sent with redundancy (every packet carries all the inputs the peer hasn't
+ confirmed yet), so a lost packet costs nothing but a later correction. A side that gets
+ too far ahead of what it has heard from the other stalls until it catches up, and a side
+ that's consistently ahead skips the odd tick so the two stay in step.
+
+ Both sides can be run on one machine over 127.0.0.1, with artificial latency and packet
+ loss added to everything sent, to try out the rollback under bad network conditions.
+ */
+
+// Port the first guy listens on by default (the second guy's is the next one up)
+#define NETPLAY_PORT 7700
+
+// Ticks a guy's own input is held back before it's used, which hides a little latency without
+// rolling back
+#define NETPLAY_INPUT_DELAY 2
+
+// Most frames a side will simulate past the last one it knows the other guy's input for
+#define NETPLAY_MAX_PREDICTION 12
+
+// How often, in frames, the two sides trade world hashes
+#define NETPLAY_CHECK_INTERVAL 60
+
+// How long to wait for the peer to show up, and for the peer to be heard from during a game, in milliseconds
+#define NETPLAY_CONNECT_TIMEOUT 60000
+#define NETPLAY_TIMEOUT 5000
+
+// Connect to the other side of a game as guy (0 or 1), listening on port and sending to peer_host:peer_port,
+// with latency milliseconds of delay and loss_percent% of packets dropped on the way out. Waits until the
+// peer is heard from, and gets the seed to play with from the first guy's side (the second guy's side
+// takes it). Returns false if the socket can't be opened or the peer never shows up
+bool startNetplay(int guy, int port, const char* peer_host, int peer_port, int latency, int loss_percent, Uint64* seed);
+
+// Check whether a netplay game is being played
+bool isNetplay(void);
+
+// Get which guy (0 or 1) is controlled on this side
+int getNetplayGuy(void);
+
+// Check whether the netplay game is still going (the peer hasn't left or gone quiet)
+bool isNetplayConnected(void);
+
+// Check whether frames are being simulated again after a misprediction (so nothing but the world is changed)
+bool isResimulating(void);
+
+// Advance the game by one tick with this side's input mask, rolling back first if the other guy's input
+// was mispredicted, with update running each tick of the simulation. Returns false if the tick had to
+// be skipped to wait for the peer
+bool playNetplayTick(World w, Uint32 input, void (*update)(World, Uint32));
+
+// Tell the peer this side is leaving, close the connection, and report how the rollback went
+void stopNetplay(void);
@@ -0,0 +1,24 @@
+/*
+ Frame pacing
+
+ Holds frames to a steady rate using the high-resolution performance counter: most of
+ the wait is a coarse sleep, and the last stretch is a spin, which lands on the deadline
+ far more precisely than SDL_Delay alone. Also measures the time between frames, so the
+ steadiness can be checked.
+ */
+
+// How long before the deadline the coarse sleep stops and the spin starts, in milliseconds
+#define SPIN_MS 2
+
+// Frame times are counted in buckets this many microseconds wide, up to MAX_FRAME_TIME_MS
+#define FRAME_TIME_BUCKET_US 10
+#define MAX_FRAME_TIME_MS 100
+
+// Pace frames to fps frames per second (0 leaves them unpaced, e.g. when vsync paces them)
+void initPacing(int fps);
+
+// Wait until it's time for the next frame to start, then record how long this frame took
+void waitForNextFrame(void);
+
+// Print the mean, 99th percentile, and maximum time between frames
+void reportFrameTimes(void);
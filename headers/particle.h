@@ -0,0 +1,109 @@
+/*
+ Particle control
+
+ Particles are the purely cosmetic debris of spells (sparks, ice shards, rock chips).
+ They never collide with sprites and have no cooldowns, so rather than going through
+ sprite control they live in fixed-capacity ring buffers, one per particle type, and
+ are updated by a single tight pass each frame. The rings belong to a world (see world.h).
+ */
+
+// Particle types are the particle entries of the identities enum (sprite.h)
+#define FIRST_PARTICLE FIREBALL_P1
+#define NUM_PARTICLE_TYPES 6
+
+// Capacity of each particle type's ring buffer, which must be a power of two (can be
+// overridden per build, e.g. make DEFS=-DPARTICLE_CAPACITY=1024). Once a ring is full,
+// new particles replace the oldest ones
+#ifndef PARTICLE_CAPACITY
+#define PARTICLE_CAPACITY 512
+#endif
+
+// The particle budget scales how many cosmetic particles spells spawn, shrinking when the busiest
+// thread nears the frame deadline (or the rings fill up) and growing back when there's room again.
+// It never goes below MIN_PARTICLE_BUDGET of the full amount
+#define MIN_PARTICLE_BUDGET 0.1
+
+// Fraction of the frame deadline in use above which the budget shrinks, and below which it grows
+#define BUDGET_SHRINK_LOAD 0.75
+#define BUDGET_GROW_LOAD 0.5
+
+// Struct for the ring buffer holding all particles of one type, as parallel arrays.
+// Particles are emitted at head and retire from the tail, oldest first - a particle that
+// dies early leaves a hole which is skipped until the tail passes it
+struct particle_ring
+{
+    int head;                               // slot the next particle will be emitted into
+    int count;                              // number of slots from the oldest particle up to head
+    int live;                               // number of those slots holding a live particle
+    int high_water;                         // most particles ever live at once
+    bool alive[PARTICLE_CAPACITY];          // does this slot hold a live particle
+    double x_pos[PARTICLE_CAPACITY];        // in-game x-coord
+    double y_pos[PARTICLE_CAPACITY];        // in-game y-coord
+    double x_prev[PARTICLE_CAPACITY];       // x-coord before the last tick, for interpolation
+    double y_prev[PARTICLE_CAPACITY];       // y-coord before the last tick, for interpolation
+    double x_vel[PARTICLE_CAPACITY];        // x-velocity
+    double y_vel[PARTICLE_CAPACITY];        // y-velocity
+    bool direction[PARTICLE_CAPACITY];      // direction currently facing
+    int angle[PARTICLE_CAPACITY];           // angle of orientation
+    int lifetime[PARTICLE_CAPACITY];        // number of frames before this particle dies automatically
+    double frame[PARTICLE_CAPACITY];        // which animation frame should be rendered on the sprite sheet
+};
+
+// Copy of everything needed to draw the live particles of each type, oldest first, captured
+// after a tick so that rendering never reads the rings while the simulation is changing them
+struct particle_view
+{
+    int count[NUM_PARTICLE_TYPES];                              // number of particles captured
+    double x_prev[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];       // x-coord before the last tick
+    double y_prev[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];       // y-coord before the last tick
+    double x_pos[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];        // x-coord after the last tick
+    double y_pos[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];        // y-coord after the last tick
+    bool direction[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];      // direction facing
+    int angle[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];           // angle of orientation
+    double frame[NUM_PARTICLE_TYPES][PARTICLE_CAPACITY];        // which animation frame is drawn
+};
+
+// Set the particle budget used by the simulation, as a fraction of the full amount of particles
+void setParticleBudget(World w, double budget);
+
+// Get the particle budget used by the simulation
+double getParticleBudget(World w);
+
+// Get the lowest the particle budget of any world has been
+double getLowestParticleBudget(void);
+
+// Scale a burst of n particles to the budget (at least one particle is always emitted, unless particles are off)
+int budgetBurst(World w, int n);
+
+// Remove every particle from a world and stop it emitting any more (for a world that's only simulated
+// to see what might happen, where particles would be wasted work)
+void turnOffParticles(World w);
+
+// Work out the next particle budget from the current one, the fraction of the frame deadline the busiest
+// thread is using, and the number of live particles
+double nextParticleBudget(double budget, double load, int live);
+
+// Render a meter showing the particle budget, for debug mode
+void renderParticleBudget(double budget);
+
+// Emit a particle of the given type
+void emitParticle(World w, int id, double x, double y, double xv, double yv, bool dir, int angle, int life);
+
+// Move all particles, and kill those that hit terrain, leave the screen, or run out of lifetime
+void updateParticles(World w, int* platforms, int* walls);
+
+// Capture everything needed to draw the live particles
+void captureParticles(World w, struct particle_view* view);
+
+// Render captured particles to the screen, alpha of the way from their previous to their current positions
+// (into the current batch, which must be on the sprite sheet)
+void renderParticles(const struct particle_view* view, double alpha);
+
+// Get the most particles of a type that have ever been live at once
+int getParticleHighWater(World w, int id);
+
+// Load particle meta info
+void loadParticles(void);
+
+// Free particle meta info
+void freeParticles(void);
@@ -0,0 +1,51 @@
+/*
+ Frame profiler
+
+ Splits each frame into phases timed with the high-resolution performance counter. The
+ game loop marks the end of each phase as it goes, and the profiler keeps a rolling
+ history of recent frames for the debug overlay, optionally writes every frame's
+ timings to a CSV file, and records each phase as a trace event when tracing.
+ */
+
+// Number of recent frames averaged for the overlay
+#define PROFILE_HISTORY 60
+
+// Phases of a frame, in the order they happen when single threaded
+enum frame_phases
+{
+    PHASE_EVENTS, PHASE_INPUT, PHASE_AI, PHASE_PARTICLES, PHASE_MOVE, PHASE_TERRAIN,
+    PHASE_COLLISIONS, PHASE_LAUNCH, PHASE_TIMERS, PHASE_UNLOAD, PHASE_ANIMATION, PHASE_CAPTURE,
+    PHASE_RENDER_LEVEL, PHASE_RENDER_PARTICLES, PHASE_RENDER_SPRITES, PHASE_RENDER_INTERFACE,
+    PHASE_PRESENT, PHASE_SLEEP, PHASE_WAIT, NUM_PHASES
+};
+
+// Threads that phases can run on. Each lane is timed separately, so when the simulation
+// runs on its own thread its phases overlap the main thread's, and can add up to more
+// than the whole frame
+enum profile_lanes
+{ LANE_MAIN, LANE_SIMULATION, NUM_LANES };
+
+// Start profiling, with the overlay shown or not, and per-frame timings written to csv_path
+// if it isn't NULL (call after initTrace). Returns false if the CSV file can't be opened
+bool initProfiler(bool overlay, const char* csv_path);
+
+// Start timing a new frame
+void beginFrame(void);
+
+// Start timing a lane's phases from now (called by the simulation thread when it picks up work)
+void beginLane(int lane);
+
+// Mark the end of a phase, charging it with the time since the last mark in its lane
+void markPhase(int phase);
+
+// Finish timing a frame, adding it to the history and the CSV file
+void endFrame(void);
+
+// Get the average time in milliseconds spent in a phase over recent frames
+double getPhaseAverage(int phase);
+
+// Draw bars breaking down recent frames by phase, one per lane (only when the overlay is shown)
+void renderProfile(void);
+
+// Close the CSV file
+void closeProfiler(void);
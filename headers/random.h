@@ -0,0 +1,61 @@
+/*
+ Random number generation
+
+ A small, fast generator (xoshiro256**) with independent streams for gameplay, cosmetic
+ effects and AI decisions, so that drawing more or fewer cosmetic numbers never changes
+ what happens in a match. All streams are derived from a single seed, which makes any
+ simulation reproducible. Each world has its own streams, so worlds never disturb one another.
+ */
+
+// Random number streams
+enum rng_streams
+{ RNG_GAMEPLAY, RNG_COSMETIC, RNG_AI, NUM_RNG_STREAMS };
+
+// Struct for the state of one random number stream
+struct rng_stream
+{
+    Uint64 s[4];
+};
+
+// Struct for the state of every stream of one world (see world.h)
+struct rng_state
+{
+    struct rng_stream streams[NUM_RNG_STREAMS];     // state of each stream
+    Uint64 seed;                                    // seed the streams were last seeded with
+};
+
+// Seed every stream from a single seed
+void seedRandom(struct rng_state* rng, Uint64 seed);
+
+// Get the seed the streams were last seeded with
+Uint64 getSeed(const struct rng_state* rng);
+
+// Pick a seed which differs from run to run
+Uint64 timeSeed(void);
+
+// Mix the state of every stream that affects gameplay into a hash (see replay.h)
+Uint64 hashRandom(const struct rng_state* rng, Uint64 hash);
+
+// Fill out[0, n) with random numbers in [0, 1) from a stream (for bursts of spawns)
+void fillRand(struct rng_state* rng, int stream, double* out, int n);
+
+// Rotate the bits of x left by k
+static inline Uint64 rotateLeft(Uint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// Get the next 64 random bits from a stream
+static inline Uint64 nextRand(struct rng_state* rng, int stream)
+{
+    Uint64* s = rng->streams[stream].s;
+    Uint64 result = rotateLeft(s[1] * 5, 7) * 9;
+    Uint64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotateLeft(s[3], 45);
+    return result;
+}
+
+// Get random number in [0, 1) from a stream
+static inline double get_rand(struct rng_state* rng, int stream) { return (nextRand(rng, stream) >> 11) * 0x1.0p-53; }
@@ -0,0 +1,64 @@
+/*
+ Replays
+
+ A replay is everything needed to play a game again exactly: the random seed, the cpu player, the input mask
+ of every simulation tick, and the mode, level, and score changes made from the menus between
+ ticks, ending with a hash of the world the game finished in. Everything else in the simulation
+ follows from these, so playing them back reproduces the game, and the hash shows whether it did.
+
+ The file is a header followed by a stream of records, each a tag byte and a variable-length
+ number: input masks are only written when they change, and runs of ticks with the same input
+ are written as a count.
+ */
+
+// Identifies a replay file ("GBRP"), and the version of its format (version 1 replays, which were all
+// played against the classic cpu, didn't store which cpu they were played against)
+#define REPLAY_MAGIC 0x50524247u
+#define REPLAY_VERSION 2
+
+// Replay records, which are also what reading a replay returns
+enum replay_records
+{ REPLAY_TICK, REPLAY_INPUT, REPLAY_MODE, REPLAY_LEVEL, REPLAY_SCORE, REPLAY_END };
+
+// Mix bytes into a 64-bit FNV-1a hash
+static inline Uint64 hashBytes(Uint64 hash, const void* data, size_t size)
+{
+    const Uint8* bytes = (const Uint8*) data;
+    for(size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+// Starting value of a hash
+#define HASH_START 0xCBF29CE484222325ULL
+
+// Start recording a replay to path of a game seeded with seed (played in debug mode or not, against
+// the given cpu player), returning false if the file can't be opened
+bool startRecording(const char* path, Uint64 seed, bool debug, int cpu);
+
+// Check whether a replay is being recorded
+bool isRecording(void);
+
+// Record the input mask of a simulation tick
+void recordTick(Uint32 input);
+
+// Record a change made between ticks (REPLAY_MODE, REPLAY_LEVEL, or REPLAY_SCORE)
+void recordEvent(int type, int value);
+
+// Finish recording with the hash of the final world, returning false if the file can't be written
+bool finishRecording(Uint64 hash);
+
+// Open a replay from path, getting the seed, mode, and cpu player it was played with, or return false if it can't be read
+bool openReplay(const char* path, Uint64* seed, bool* debug, int* cpu);
+
+// Check whether a replay is being played back
+bool isReplaying(void);
+
+// Read the replay up to its next tick. Returns REPLAY_TICK with the tick's input mask, a change to make
+// before it (REPLAY_MODE, REPLAY_LEVEL, or REPLAY_SCORE) with its value, or REPLAY_END at the end
+int readReplay(Uint32* input, int* value);
+
+// Get the number of ticks and world hash stored at the end of the replay (once it has been read)
+void getReplayEnd(long long* ticks, Uint64* hash);
+
+// Close the replay
+void closeReplay(void);
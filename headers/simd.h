@@ -0,0 +1,39 @@
+/*
+ SIMD kernels
+
+ Small array kernels used to update whole batches of particles at once. The widest
+ instruction set the CPU supports (AVX2, SSE2, or plain scalar code) is chosen at
+ runtime. In verification mode every kernel also runs the scalar version and counts
+ any results that differ.
+ */
+
+// Instruction sets the kernels can use
+enum simd_levels
+{ SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+// Choose the kernels to use - level is the widest instruction set allowed, and verify turns on verification
+void initSIMD(int level, bool verify);
+
+// Look up an instruction set by name ("scalar", "sse2", "avx2"), returning -1 if there's no such set
+int simdByName(const char* name);
+
+// Get the name of the instruction set in use
+const char* getSIMDName(void);
+
+// Get whether verification mode is on
+bool getSIMDVerify(void);
+
+// Get how many results have differed from the scalar kernels in verification mode
+long long getSIMDMismatches(void);
+
+// a[i] += b[i] for i in [0, n)
+void addArrays(double* a, const double* b, int n);
+
+// a[i] += k for i in [0, n)
+void addConstant(double* a, double k, int n);
+
+// a[i] += k for i in [0, n), on integers
+void addConstantInt(int* a, int k, int n);
+
+// Slow a[i] down by d, i.e. a[i] += (a[i] < 0 ? d : -d) for i in [0, n)
+void applyDrag(double* a, double d, int n);
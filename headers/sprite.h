@@ -3,13 +3,19 @@
 
  A sprite is a spell, particle, or player character. Sprite control thus
  includes physics, animation, collision, and generally the bulk of the
- game's code.
+ game's code. Sprite and spell meta info is loaded once and shared, while the sprites
+ themselves belong to a world (see world.h).
  */
 
 // Number of distinct spells and sprites in the game
 #define NUM_SPRITES 12
 #define NUM_SPELLS 5
 
+// Capacity of the sprite pool (can be overridden per build, e.g. make DEFS=-DMAX_SPRITES=2048)
+#ifndef MAX_SPRITES
+#define MAX_SPRITES 1024
+#endif
+
 // Sprite list - doubles as the spell list, so spells must come first
 enum identities
 { FIREBALL,    ICESHOCK,    ROCKFALL,                 DARKEDGE,    ARCSURGE,
@@ -19,69 +25,157 @@ enum identities
 enum action_types
 { SPAWN, MOVE, COLLIDE, IDLE, JUMP, CAST_FIREBALL, CAST_ICESHOCK, CAST_ROCKFALL, CAST_DARKEDGE, CAST_ARCSURGE, DIE };
 
-// Sprite types
+// Sprite types (particles are handled separately, see particle.h)
 enum types
 { HUMANOID, PARTICLE, SPELL };
 
+// Pool index that stands for no record (see world.h)
+#define NO_RECORD -1
+
 // Allow main to pass around Guy sprites
 typedef struct sprite* Sprite;
 
+// Meta info shared by every sprite of a kind, which is the same in every world (see sprite.c)
+typedef struct sprite_metainfo* SpriteInfo;
+
+// Struct for the permanent record of a currently active sprite
+// (its per-frame state lives in the sprite store, at index slot, and its meta info is sprite_info[id])
+struct sprite
+{
+    int slot;                   // where this sprite's state is in the sprite store
+    int spell;                  // spell currently in use
+    int cooldowns[NUM_SPELLS];  // array of spell cooldowns (only used by humans)
+    int next;                   // pool index of the next unused record, while this record is in the sprite pool
+};
+
+// Struct for the state of all active sprites, as parallel arrays indexed by slot
+// (the per-frame passes sweep these arrays rather than chasing pointers)
+struct sprite_store
+{
+    int count;                          // number of active sprites, which occupy slots [0, count)
+    int record[MAX_SPRITES];            // pool index of the record of the sprite in each slot
+
+    // Identity info
+    int id[MAX_SPRITES];                // what sprite is this (FIREBALL, GUY, etc)
+    int type[MAX_SPRITES];              // what kind of sprite is this (HUMANOID, SPELL)
+
+    // Positional info
+    double x_pos[MAX_SPRITES];          // in-game x-coord
+    double y_pos[MAX_SPRITES];          // in-game y-coord
+    double x_prev[MAX_SPRITES];         // x-coord before the last tick, for interpolation
+    double y_prev[MAX_SPRITES];         // y-coord before the last tick, for interpolation
+    double x_vel[MAX_SPRITES];          // x-velocity
+    double y_vel[MAX_SPRITES];          // y-velocity
+    bool direction[MAX_SPRITES];        // direction currently facing
+    int angle[MAX_SPRITES];             // angle of orientation
+
+    // Action info
+    int hp[MAX_SPRITES];                // current hp
+    int spawning[MAX_SPRITES];          // number of frames left in spawn animation
+    int colliding[MAX_SPRITES];         // number of frames left in collision
+    int casting[MAX_SPRITES];           // number of frames left to cast spell
+    int lifetime[MAX_SPRITES];          // number of frames before this sprite dies automatically
+    int action[MAX_SPRITES];            // which animation is the sprite in (MOVE, JUMP, etc)
+    bool action_change[MAX_SPRITES];    // has sprite's action changed to a different one this frame
+    double frame[MAX_SPRITES];          // which animation frame should be rendered on the sprite sheet
+};
+
+// Copy of everything needed to draw the active sprites, captured after a tick so that
+// rendering never reads the sprite store while the simulation is changing it
+struct sprite_view
+{
+    int count;                          // number of sprites captured
+    int id[MAX_SPRITES];                // what sprite is this (FIREBALL, GUY, etc)
+    double x_prev[MAX_SPRITES];         // x-coord before the last tick
+    double y_prev[MAX_SPRITES];         // y-coord before the last tick
+    double x_pos[MAX_SPRITES];          // x-coord after the last tick
+    double y_pos[MAX_SPRITES];          // y-coord after the last tick
+    bool direction[MAX_SPRITES];        // direction facing
+    int angle[MAX_SPRITES];             // angle of orientation
+    double frame[MAX_SPRITES];          // which animation frame is drawn
+};
+
+// Thread every record of a world's sprite pool onto the free list, leaving no sprites active
+void initSpritePool(World w);
+
 // Spawn (construct) a sprite with the given fields
-void spawnSprite(int id, double x, double y, double xv, double yv, bool dir, int angle, int spawning, int life);
+void spawnSprite(World w, int id, double x, double y, double xv, double yv, bool dir, int angle, int spawning, int life);
 
 // Hide a guy in the top right corner of the map
-void hideGuy(int guy);
+void hideGuy(World w, int guy);
 
 // Reset the health and cooldowns and position of a guy
-void resetGuy(int guy, int x, int y);
+void resetGuy(World w, int guy, int x, int y);
+
+// Get the texture containing all sprites
+SDL_Texture* getSpriteSheet(void);
+
+// Get the most sprite pool slots that have ever been in use at once
+int getPoolHighWater(World w);
+
+// Get the total number of sprite pairs that could have collided, that were checked, and that collided
+void getCollisionStats(World w, long long* possible, long long* tested, long long* hits);
+
+// Get how many times a spell has been cast, how many times it has hit a guy, and how much damage it has done to guys
+void getSpellStats(World w, int spell, int* casts, int* hits, int* damage);
+
+// Mix the gameplay state of every active sprite into a hash (see replay.h)
+Uint64 hashSprites(World w, Uint64 hash);
+
+// Get the slot in the sprite store a guy's state is in
+int guySlot(World w, int guy);
 
 // Get a guy's health remaining
-int getHealth(int guy);
+int getHealth(World w, int guy);
 
-// Get an array of percentages of a guy's cooldowns
-double* getCooldowns(int guy);
+// Fill an array of NUM_SPELLS + 1 doubles with percentages of a guy's cooldowns
+void getCooldowns(World w, int guy, double* cooldown_percentages);
+
+// Check whether a guy has a platform (or the ground) somewhere under him to land on
+bool overPlatform(World w, int guy, int* platforms);
 
 // Attempt to walk in a direction after a keyboard input
-bool walk(int guy, bool left_or_right);
+bool walk(World w, int guy, bool left_or_right);
 
 // Attempt to jump after a keyboard input
-bool jump(int guy);
+bool jump(World w, int guy);
 
 // Attempt to cast a spell after a keyboard input
-bool cast(int guy, int spell);
-
-// In 1-player mode, process AI decisions
-void takeCPUAction(void);
+bool cast(World w, int guy, int spell);
 
 // Check if its time to spawn new spells, and spawn them, returning the change in score
-void launchSpells(void);
+void launchSpells(World w);
 
 // Check for and handle terrain collisions for all active sprites
-void terrainCollisions(int* platforms, int* walls);
+void terrainCollisions(World w, int* platforms, int* walls);
 
 // Check for and handle collisions between all active sprites
-void spriteCollisions();
+void spriteCollisions(World w);
 
 // Update the animation frame which is drawn for all active sprites
-void updateAnimationFrames(void);
+void updateAnimationFrames(World w);
 
 // Update position/orientation/velocity of all active sprites
-void moveSprites(void);
+void moveSprites(World w);
 
 // Advance timed sprite variables which update every frame
-void advanceTimers(void);
+void advanceTimers(World w);
+
+// Capture everything needed to draw the active sprites
+void captureSprites(World w, struct sprite_view* view);
 
-// Render all active sprites to the screen
-void renderSprites(void);
+// Render captured sprites to the screen, alpha of the way from their previous to their current positions
+// (into the current batch, which must be on the sprite sheet)
+void renderSprites(const struct sprite_view* view, double alpha);
 
 // Load sprite and spell data
 void loadSpriteInfo(void);
 
 // Unload any active sprites which have died
-int unloadSprites(void);
+int unloadSprites(World w);
 
 // Destroy all active sprites
-void freeActiveSprites(void);
+void freeActiveSprites(World w);
 
 // Free sprite and spell data
 void freeSpriteInfo(void);
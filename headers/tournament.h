@@ -0,0 +1,22 @@
+/*
+ Tournaments
+
+ Plays many headless cpu vs cpu matches, for checking how balanced the spells are without
+ playing by hand. Every match is a world of its own, seeded from the tournament's seed and
+ the match's number, so the results don't depend on how many threads play them or in what
+ order. Worker threads (one per core, including the main thread) keep taking the next
+ unplayed match off a shared counter until there are none left, so no core sits idle while
+ another is still working through a queue, however long each match runs. Once every match
+ is done, the results are added up into a summary of win rates, match lengths, and what
+ each spell did.
+ */
+
+// Longest a match can run before it's called a draw (five minutes of game time)
+#define MATCH_FRAME_LIMIT (5 * 60 * MAX_FPS)
+
+// Most worker threads a tournament will start
+#define MAX_TOURNAMENT_THREADS 256
+
+// Play a tournament of num_matches matches on num_threads threads (one per core if 0), and print a
+// summary of the results. Returns false if the results or worlds can't be allocated
+bool runTournament(int num_matches, int num_threads, Uint64 seed);
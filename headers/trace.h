@@ -0,0 +1,40 @@
+/*
+ Event tracing
+
+ Records begin and end events for frame phases and expensive handlers into a ring buffer
+ allocated up front, and writes them out as a Chrome trace (JSON, viewable in
+ chrome://tracing or Perfetto) when the game quits. When the ring fills up, the oldest
+ events are overwritten, so the trace always holds the most recent frames.
+
+ The main thread and the simulation thread each record into a ring of their own.
+ */
+
+// Number of events the ring holds (must be a power of two, can be overridden per build)
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY (1 << 18)
+#endif
+
+// Number of event rings: one for the main thread, and one shared by any other thread
+// (only the simulation thread records while the game is running)
+#define TRACE_THREADS 2
+
+// Start tracing, writing the trace to path at exit. Returns false if memory can't be allocated
+bool initTrace(const char* path);
+
+// Check whether events are being recorded
+bool isTracing(void);
+
+// Record an event which happened at a given performance counter value ('B' for begin, 'E' for end)
+void traceEventAt(const char* name, char type, Uint64 ticks);
+
+// Record the beginning of a named event now
+void traceBegin(const char* name);
+
+// Record the end of a named event now
+void traceEnd(const char* name);
+
+// Drop (or stop dropping) the events the calling thread records, e.g. while simulating what might happen
+void muteTrace(bool muted);
+
+// Write the recorded events to the trace file and stop tracing, returning false if it can't be written
+bool flushTrace(void);
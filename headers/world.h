@@ -0,0 +1,118 @@
+/*
+ Worlds
+
+ A world is everything that changes as a game is played: the game mode and frame count,
+ the score, the sprites and their collision bookkeeping, the particles, the backgrounds'
+ drift, and the random number streams. Every simulation function is handed the world it
+ works on, and nothing it changes lives anywhere else, so any number of worlds can be
+ simulated side by side (on separate threads, as long as each world stays on one). Meta
+ info (sprite_info, spell_info, particle and level data) is loaded once and shared by all
+ worlds, which only ever read it.
+
+ A world holds no pointers - sprites refer to each other and to their records by index -
+ so it can be snapshotted into a flat buffer with a single copy, and a snapshot can be
+ restored into any world, which is what makes rollback and lookahead cheap. Only the
+ scratch space at the end of a world, which is rebuilt every frame, is left out.
+
+ Include after sprite.h, broadphase.h, particle.h, level.h, random.h, and cpu.h.
+ */
+
+// Struct for a world (see above)
+struct world
+{
+    // Progress of the game
+    int mode;                                           // game mode (see interface.h)
+    long long frame;                                    // number of ticks simulated so far
+    int score;                                          // the score, for 1-player games
+
+    // Sprites (see sprite.c)
+    struct sprite_store active;                         // state of all currently active sprites
+    int guys[2];                                        // pool index of each guy's record, which is never freed
+    struct sprite sprite_pool[MAX_SPRITES];             // fixed storage for the records of every active sprite
+    int free_records;                                   // first unused record in the sprite pool, which are linked by index
+    int pool_high_water;                                // most sprites ever active at once
+
+    // Collision detection (see sprite.c and broadphase.c)
+    long long pairs_possible;                           // pairs of colliders that a brute force check would have tested
+    long long pairs_tested;                             // candidate pairs from the broadphase that were checked precisely
+    long long pairs_hit;                                // checked pairs that were actually colliding
+    struct sweep sweep;                                 // sweep and prune list, kept from frame to frame
+
+    // Spell statistics, for balance testing (see sprite.c)
+    int spell_casts[NUM_SPELLS];                        // number of times each spell has been cast
+    int spell_hits[NUM_SPELLS];                         // number of times each spell has hit a guy
+    int spell_damage[NUM_SPELLS];                       // total damage each spell has done to guys
+
+    // Level (see level.c)
+    int current_background;                             // current background
+    int current_foreground;                             // current foreground
+    struct background_state background_states[NUM_BACKGROUNDS]; // position and velocity of each background
+
+    // Random numbers (see random.c)
+    struct rng_state rng;                               // state of every random number stream
+
+    // Cpu players (see cpu.c)
+    struct cpu_plan plans[2];                           // what each guy is thinking about and doing, when the cpu controls him
+
+    // Particles, which are purely cosmetic and so come after everything gameplay depends on (see particle.c)
+    struct particle_ring particles[NUM_PARTICLE_TYPES]; // ring buffer of particles of each type
+    double particle_budget;                             // fraction of the full amount of cosmetic particles spawned
+
+    // Scratch space, which is rebuilt every frame and isn't part of a snapshot (must come last)
+    int colliders[MAX_SPRITES];                         // slots of the sprites that can collide this frame
+    int collider_key[MAX_SPRITES];                      // pool index of each collider's record, which is stable between frames
+    double collider_x[MAX_SPRITES];                     // bounding circle center x of each collider
+    double collider_y[MAX_SPRITES];                     // bounding circle center y of each collider
+    double collider_r[MAX_SPRITES];                     // bounding circle radius of each collider
+    struct grid grid;                                   // uniform grid, rebuilt for every frame's colliders
+    struct candidates candidates;                       // candidate pairs from the broadphase, put in order before they're checked
+    World lookahead;                                    // scratch world the cpu guys simulate ahead in (NULL in a scratch world)
+};
+
+// Size in bytes of a world snapshot, which is everything in a world before its scratch space
+#define SNAPSHOT_SIZE offsetof(struct world, colliders)
+
+// Size in bytes of the part of a snapshot that gameplay depends on, which is everything before the particles
+#define GAMEPLAY_SIZE offsetof(struct world, particles)
+
+// Create a world at the start of the opening scene on the first level, with no sprites, and with its
+// random numbers seeded from seed (levels, sprite info, and particles must already be loaded), along
+// with the scratch world its cpu guys simulate ahead in. Returns NULL if they can't be allocated
+World newWorld(Uint64 seed);
+
+// Put a world back to the start of the opening scene on the first level, with no sprites, and with
+// its random numbers seeded from seed
+void resetWorld(World w, Uint64 seed);
+
+// Advance a world's simulation by one frame, returning which guy died (1 or 2) or 0
+int stepSimulation(World w);
+
+// Advance a world's simulation by one frame without profiling or tracing it, for simulating what might happen
+int stepLookahead(World w);
+
+// Free a world and everything in it (nothing happens for NULL, like free)
+void freeWorld(World w);
+
+// Save everything in a world into a buffer of SNAPSHOT_SIZE bytes
+void saveWorld(World w, void* snapshot);
+
+// Restore a world from a snapshot saved from it or from any other world
+void restoreWorld(World w, const void* snapshot);
+
+// Make one world an exact copy of another
+void copyWorld(World dst, World src);
+
+// Make one world a copy of another's gameplay, with no particles and none to come (for simulating what might happen)
+void copyGameplay(World dst, World src);
+
+// Change the score
+void setScore(World w, int new_score);
+
+// Add points to score
+void updateScore(World w, int points);
+
+// Get the score
+int getScore(World w);
+
+// Hash everything in a world that affects gameplay (see replay.h)
+Uint64 hashWorld(World w);
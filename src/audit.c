@@ -0,0 +1,123 @@
+#define AUDIT_NO_REDIRECT
+#include "../headers/constants.h"
+#include "../headers/audit.h"
+
+bool auditing = false;                  // Whether allocations are being checked each frame
+long long audited_frames = 0;           // Number of frames checked so far
+long long flagged_frames = 0;           // Number of frames after the warm-up that allocated
+long long flagged_allocs = 0;           // Allocations made in those frames
+
+#ifdef ALLOC_AUDIT
+SDL_atomic_t frame_allocs;              // Allocations since the last frame ended (from any thread)
+SDL_atomic_t frame_frees;               // Frees since the last frame ended (from any thread)
+
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+SDL_malloc_func sdl_malloc;             // SDL's own allocation functions, which the audited ones wrap
+SDL_calloc_func sdl_calloc;
+SDL_realloc_func sdl_realloc;
+SDL_free_func sdl_free;
+#endif
+
+/* COUNTING WRAPPERS */
+
+// Count and make an allocation
+void* auditMalloc(size_t size)
+{
+    SDL_AtomicAdd(&frame_allocs, 1);
+    return malloc(size);
+}
+
+// Count and make a zeroed allocation
+void* auditCalloc(size_t count, size_t size)
+{
+    SDL_AtomicAdd(&frame_allocs, 1);
+    return calloc(count, size);
+}
+
+// Count and make a reallocation
+void* auditRealloc(void* ptr, size_t size)
+{
+    SDL_AtomicAdd(&frame_allocs, 1);
+    return realloc(ptr, size);
+}
+
+// Count and free an allocation
+void auditFree(void* ptr)
+{
+    if(ptr) SDL_AtomicAdd(&frame_frees, 1);
+    free(ptr);
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+// Count and make an allocation for SDL
+static void* SDLCALL auditSDLMalloc(size_t size)
+{
+    SDL_AtomicAdd(&frame_allocs, 1);
+    return sdl_malloc(size);
+}
+
+// Count and make a zeroed allocation for SDL
+static void* SDLCALL auditSDLCalloc(size_t count, size_t size)
+{
+    SDL_AtomicAdd(&frame_allocs, 1);
+    return sdl_calloc(count, size);
+}
+
+// Count and make a reallocation for SDL
+static void* SDLCALL auditSDLRealloc(void* ptr, size_t size)
+{
+    SDL_AtomicAdd(&frame_allocs, 1);
+    return sdl_realloc(ptr, size);
+}
+
+// Count and free an allocation for SDL
+static void SDLCALL auditSDLFree(void* ptr)
+{
+    if(ptr) SDL_AtomicAdd(&frame_frees, 1);
+    sdl_free(ptr);
+}
+#endif
+#endif
+
+/* AUDITING */
+
+// Start auditing allocations, or return false if not built with ALLOC_AUDIT
+bool initAudit()
+{
+#ifdef ALLOC_AUDIT
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+    // SDL's memory functions can only be swapped before anything has been allocated with them
+    SDL_GetMemoryFunctions(&sdl_malloc, &sdl_calloc, &sdl_realloc, &sdl_free);
+    SDL_SetMemoryFunctions(auditSDLMalloc, auditSDLCalloc, auditSDLRealloc, auditSDLFree);
+#endif
+    SDL_AtomicSet(&frame_allocs, 0);
+    SDL_AtomicSet(&frame_frees, 0);
+    auditing = true;
+#endif
+    return auditing;
+}
+
+// Check the allocations made since the last frame ended, logging them if the warm-up is over
+void auditFrame()
+{
+    if(!auditing) return;
+#ifdef ALLOC_AUDIT
+    int allocs = SDL_AtomicSet(&frame_allocs, 0);
+    int frees = SDL_AtomicSet(&frame_frees, 0);
+    if(audited_frames >= AUDIT_WARMUP && (allocs || frees))
+    {
+        printf("Frame %lld: %d allocations, %d frees\n", audited_frames, allocs, frees);
+        flagged_frames++;
+        flagged_allocs += allocs;
+    }
+#endif
+    audited_frames++;
+}
+
+// Print how many frames allocated after the warm-up
+void reportAudit()
+{
+    if(!auditing) return;
+    printf("Allocation audit: %lld of %lld frames after warm-up touched the heap (%lld allocations)\n",
+           flagged_frames, audited_frames > AUDIT_WARMUP ? audited_frames - AUDIT_WARMUP : 0, flagged_allocs);
+}
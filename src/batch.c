@@ -0,0 +1,130 @@
+#include "../headers/constants.h"
+#include "../headers/batch.h"
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+bool batching = true;                       // Whether quads are collected rather than drawn one by one
+#else
+bool batching = false;
+#endif
+
+SDL_Texture* batch_texture = NULL;          // Texture every quad in the batch comes from
+float texture_width = 1;                    // Width of the texture in pixels
+float texture_height = 1;                   // Height of the texture in pixels
+int batch_count = 0;                        // Number of quads in the batch
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+SDL_Vertex batch_vertices[BATCH_QUADS * 4]; // Corners of each quad, clockwise from the top left
+int batch_indices[BATCH_QUADS * 6];         // Two triangles per quad, which never change
+bool indices_ready = false;                 // Whether the triangles have been filled in
+#endif
+
+/* SETUP */
+
+// Turn batching on or off
+void setBatching(bool on)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    batching = on;
+#else
+    (void) on;
+#endif
+}
+
+// Check whether quads are actually being batched
+bool isBatching()
+{
+    return batching;
+}
+
+// Start a batch of quads from a texture
+void beginBatch(SDL_Texture* texture)
+{
+    batch_texture = texture;
+    batch_count = 0;
+    if(!batching) return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // Every quad is two triangles of its four corners
+    if(!indices_ready)
+    {
+        for(int q = 0; q < BATCH_QUADS; q++)
+        {
+            int* tri = &batch_indices[q * 6];
+            tri[0] = q * 4;     tri[1] = q * 4 + 1;     tri[2] = q * 4 + 2;
+            tri[3] = q * 4;     tri[4] = q * 4 + 2;     tri[5] = q * 4 + 3;
+        }
+        indices_ready = true;
+    }
+
+    // Texture coordinates are fractions of the texture's size
+    int w = 1, h = 1;
+    SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+    texture_width = w;
+    texture_height = h;
+#endif
+}
+
+/* BATCHING */
+
+// Add a quad to the batch
+void batchCopy(const SDL_Rect* clip, const SDL_Rect* dst, double angle, SDL_RendererFlip flip)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if(batching)
+    {
+        if(batch_count == BATCH_QUADS) flushBatch();
+
+        // Texture coordinates of the clip's edges, swapped left to right when flipped
+        float u0 = clip->x / texture_width;
+        float u1 = (clip->x + clip->w) / texture_width;
+        float v0 = clip->y / texture_height;
+        float v1 = (clip->y + clip->h) / texture_height;
+        if(flip & SDL_FLIP_HORIZONTAL)
+        {
+            float tmp = u0;
+            u0 = u1;
+            u1 = tmp;
+        }
+
+        // Rotate the corners around the middle of the destination (clockwise, since y points down)
+        double radians = angle / 57.296;
+        float c = (float) cos(radians);
+        float s = (float) sin(radians);
+        float cx = dst->x + dst->w / 2.0f;
+        float cy = dst->y + dst->h / 2.0f;
+        float hw = dst->w / 2.0f;
+        float hh = dst->h / 2.0f;
+        const float corner_x[4] = {-hw, hw, hw, -hw};
+        const float corner_y[4] = {-hh, -hh, hh, hh};
+        const float corner_u[4] = {u0, u1, u1, u0};
+        const float corner_v[4] = {v0, v0, v1, v1};
+
+        SDL_Vertex* v = &batch_vertices[batch_count * 4];
+        for(int k = 0; k < 4; k++)
+        {
+            v[k].position.x = cx + corner_x[k] * c - corner_y[k] * s;
+            v[k].position.y = cy + corner_x[k] * s + corner_y[k] * c;
+            v[k].color = (SDL_Color) {0xFF, 0xFF, 0xFF, 0xFF};
+            v[k].tex_coord.x = corner_u[k];
+            v[k].tex_coord.y = corner_v[k];
+        }
+        batch_count++;
+        return;
+    }
+#endif
+
+    // Without batching, draw the quad right away
+    SDL_RenderCopyEx(renderer, batch_texture, clip, dst, angle, NULL, flip);
+}
+
+// Submit the quads added since the batch began or was last flushed
+void flushBatch()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if(batching && batch_count)
+    {
+        SDL_RenderGeometry(renderer, batch_texture, batch_vertices, batch_count * 4, batch_indices, batch_count * 6);
+    }
+#endif
+    batch_count = 0;
+}
@@ -0,0 +1,265 @@
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/level.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/world.h"
+
+// Broadphase method used by every world
+int broadphase = DEFAULT_BROADPHASE;
+
+/* BROADPHASE SELECTION */
+
+// Choose which broadphase method findPairs uses
+void setBroadphase(int method)
+{
+    broadphase = method;
+}
+
+// Look up a broadphase method by name, returning -1 if there's no such method
+int broadphaseByName(const char* name)
+{
+    if(!strcmp(name, "brute")) return BRUTE_FORCE;
+    if(!strcmp(name, "grid"))  return GRID;
+    if(!strcmp(name, "sweep")) return SWEEP;
+    return -1;
+}
+
+// Hold on to a candidate pair from the grid or the sweep, to be put in order once they've all been found
+static void collectPair(World w, int a, int b)
+{
+    struct candidates* candidates = &w->candidates;
+    if(candidates->count < MAX_CANDIDATE_PAIRS)
+    {
+        candidates->pairs[candidates->count] = a < b ? a * MAX_SPRITES + b : b * MAX_SPRITES + a;
+    }
+    candidates->count++;
+}
+
+// Counting sort pairs of n colliders by their first or second collider, keeping pairs with the same one in order
+static void sortPairsBy(const int* in, int* out, int count, int* starts, int n, bool by_first)
+{
+    for(int k = 0; k <= n; k++) starts[k] = 0;
+    for(int p = 0; p < count; p++) starts[(by_first ? in[p] / MAX_SPRITES : in[p] % MAX_SPRITES) + 1]++;
+    for(int k = 0; k < n; k++) starts[k + 1] += starts[k];
+    for(int p = 0; p < count; p++) out[starts[by_first ? in[p] / MAX_SPRITES : in[p] % MAX_SPRITES]++] = in[p];
+}
+
+// Sort the candidate pairs of n colliders into the order brute force reports pairs in, with a radix sort
+// (by second collider, then by first) so that a frame with lots of candidates doesn't cost quadratic time
+static void sortCandidates(struct candidates* candidates, int n)
+{
+    sortPairsBy(candidates->pairs, candidates->sorted, candidates->count, candidates->starts, n, false);
+    sortPairsBy(candidates->sorted, candidates->pairs, candidates->count, candidates->starts, n, true);
+}
+
+// Report every pair of colliders which might overlap, using the chosen broadphase, in brute force order
+void findPairs(World w, int n, const int* keys, const double* x, const double* y, const double* r, void (*on_pair)(World, int, int))
+{
+    // Brute force finds the pairs in order already, and the others' pairs are collected to be sorted
+    struct candidates* candidates = &w->candidates;
+    candidates->count = 0;
+    switch(broadphase)
+    {
+        case BRUTE_FORCE:
+            findPairsBrute(w, n, on_pair);
+            return;
+
+        case GRID:
+            findPairsGrid(w, n, x, y, r, collectPair);
+            break;
+
+        case SWEEP:
+            findPairsSweep(w, n, keys, x, y, r, collectPair);
+            break;
+    }
+
+    // If there are too many candidates to hold, checking every pair gives the same results, just slower
+    if(candidates->count > MAX_CANDIDATE_PAIRS)
+    {
+        findPairsBrute(w, n, on_pair);
+        return;
+    }
+    sortCandidates(candidates, n);
+    for(int p = 0; p < candidates->count; p++)
+    {
+        on_pair(w, candidates->pairs[p] / MAX_SPRITES, candidates->pairs[p] % MAX_SPRITES);
+    }
+}
+
+/* BRUTE FORCE */
+
+// Report every pair of colliders, without any culling
+void findPairsBrute(World w, int n, void (*on_pair)(World, int, int))
+{
+    for(int a = 0; a < n; a++)
+    {
+        for(int b = a + 1; b < n; b++) on_pair(w, a, b);
+    }
+}
+
+/* UNIFORM GRID */
+
+// Get the cell coordinate of a position along one axis, clamped to the grid
+static int cellCoord(const struct grid* grid, double pos, double origin, int cells)
+{
+    int c = (int) floor((pos - origin) / grid->cell_size);
+    if(c < 0) return 0;
+    if(c >= cells) return cells - 1;
+    return c;
+}
+
+// Bucket all colliders into the grid with a counting sort on their cell, touching only occupied cells
+static void buildGrid(struct grid* grid, int n, const double* x, const double* y, const double* r)
+{
+    // A cell must be at least as wide as the largest possible sum of two radii, so that any
+    // overlapping pair is in the same or neighbouring cells
+    double max_r = 0;
+    for(int i = 0; i < n; i++) max_r = fmax(max_r, r[i]);
+    grid->cell_size = fmax(2 * max_r, MIN_CELL_SIZE);
+    grid->cols = (int) ceil(WORLD_WIDTH / grid->cell_size);
+    grid->rows = (int) ceil(WORLD_HEIGHT / grid->cell_size);
+
+    // Count colliders per cell, noting each cell the first time a collider lands in it
+    grid->num_occupied = 0;
+    for(int i = 0; i < n; i++)
+    {
+        int cx = cellCoord(grid, x[i], WORLD_LEFT, grid->cols);
+        int cy = cellCoord(grid, y[i], WORLD_TOP, grid->rows);
+        int cell = cy * grid->cols + cx;
+        grid->cell_of[i] = cell;
+        if(grid->cell_count[cell]++ == 0) grid->occupied[grid->num_occupied++] = cell;
+    }
+
+    // Give each occupied cell a range of members, place each collider by advancing its cell's start
+    // past it, then move the starts back
+    int start = 0;
+    for(int o = 0; o < grid->num_occupied; o++)
+    {
+        int cell = grid->occupied[o];
+        grid->cell_start[cell] = start;
+        start += grid->cell_count[cell];
+    }
+    for(int i = 0; i < n; i++) grid->members[grid->cell_start[grid->cell_of[i]]++] = i;
+    for(int o = 0; o < grid->num_occupied; o++) grid->cell_start[grid->occupied[o]] -= grid->cell_count[grid->occupied[o]];
+}
+
+// Report every pair of the n colliders which might overlap, using a uniform grid
+void findPairsGrid(World w, int n, const double* x, const double* y, const double* r, void (*on_pair)(World, int, int))
+{
+    struct grid* grid = &w->grid;
+    buildGrid(grid, n, x, y, r);
+
+    // Only half of the neighbouring cells are visited from each cell, so each pair of cells
+    // (and therefore each pair of colliders) is only considered once
+    static const int neighbours[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+    for(int o = 0; o < grid->num_occupied; o++)
+    {
+        int cell = grid->occupied[o];
+        int cx = cell % grid->cols;
+        int cy = cell / grid->cols;
+        int start = grid->cell_start[cell];
+        int end = start + grid->cell_count[cell];
+
+        // Pairs within this cell
+        for(int a = start; a < end; a++)
+        {
+            for(int b = a + 1; b < end; b++) on_pair(w, grid->members[a], grid->members[b]);
+        }
+
+        // Pairs between this cell and its forward neighbours (an empty cell has a count of zero)
+        for(int k = 0; k < 4; k++)
+        {
+            int nx = cx + neighbours[k][0];
+            int ny = cy + neighbours[k][1];
+            if(nx < 0 || nx >= grid->cols || ny >= grid->rows) continue;
+            int other = ny * grid->cols + nx;
+            int other_start = grid->cell_start[other];
+            int other_end = other_start + grid->cell_count[other];
+            for(int a = start; a < end; a++)
+            {
+                for(int b = other_start; b < other_end; b++) on_pair(w, grid->members[a], grid->members[b]);
+            }
+        }
+    }
+
+    // Leave every cell empty for the next frame, by zeroing only the cells that were used
+    for(int o = 0; o < grid->num_occupied; o++) grid->cell_count[grid->occupied[o]] = 0;
+}
+
+/* SWEEP AND PRUNE */
+
+// Bring the sweep list up to date with this frame's colliders, keeping the previous frame's order
+static void updateSweepList(struct sweep* sweep, int n, const int* keys, const double* x, const double* r)
+{
+    // Note where each key is in this frame's input
+    for(int k = 0; k < MAX_SPRITES; k++) sweep->key_index[k] = -1;
+    for(int i = 0; i < n; i++) sweep->key_index[keys[i]] = i;
+
+    // Drop colliders that are gone and refresh the intervals of the rest, without disturbing their order
+    int kept = 0;
+    for(int e = 0; e < sweep->count; e++)
+    {
+        struct interval it = sweep->list[e];
+        int i = sweep->key_index[it.key];
+        if(i == -1)
+        {
+            sweep->listed[it.key] = false;
+            continue;
+        }
+        it.index = i;
+        it.min_x = x[i] - r[i];
+        it.max_x = x[i] + r[i];
+        sweep->list[kept++] = it;
+    }
+    sweep->count = kept;
+
+    // New colliders go on the end of the list
+    for(int i = 0; i < n; i++)
+    {
+        if(sweep->listed[keys[i]]) continue;
+        sweep->listed[keys[i]] = true;
+        sweep->list[sweep->count++] = (struct interval) {keys[i], i, x[i] - r[i], x[i] + r[i]};
+    }
+}
+
+// Re-sort the sweep list by the left edges of the intervals
+static void sortSweepList(struct sweep* sweep)
+{
+    // Sprites only move a few pixels per frame, so the list is nearly sorted already and
+    // insertion sort runs in close to linear time
+    for(int e = 1; e < sweep->count; e++)
+    {
+        struct interval it = sweep->list[e];
+        int f = e - 1;
+        while(f >= 0 && sweep->list[f].min_x > it.min_x)
+        {
+            sweep->list[f + 1] = sweep->list[f];
+            f--;
+        }
+        sweep->list[f + 1] = it;
+    }
+}
+
+// Report every pair of colliders which might overlap, by sweeping along the x axis
+void findPairsSweep(World w, int n, const int* keys, const double* x, const double* y, const double* r, void (*on_pair)(World, int, int))
+{
+    struct sweep* sweep = &w->sweep;
+    updateSweepList(sweep, n, keys, x, r);
+    sortSweepList(sweep);
+
+    // Each interval only needs to be compared with the intervals that start before it ends
+    for(int e = 0; e < sweep->count; e++)
+    {
+        struct interval a = sweep->list[e];
+        for(int f = e + 1; f < sweep->count && sweep->list[f].min_x < a.max_x; f++)
+        {
+            // Prune pairs which are too far apart along the y axis
+            int b = sweep->list[f].index;
+            if(fabs(y[a.index] - y[b]) >= r[a.index] + r[b]) continue;
+            on_pair(w, a.index, b);
+        }
+    }
+}
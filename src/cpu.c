@@ -0,0 +1,175 @@
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/level.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/world.h"
+
+// How the lookahead cpu weighs an outcome: damage it takes against damage it deals, either guy dying,
+// heading off the level (worth half a KO), what a spell's cooldown is worth, and how far from the other guy it likes to keep
+#define TAKEN_WEIGHT 1.25
+#define KO_SCORE 1000
+#define CAST_COST 0.5
+#define DISTANCE_WEIGHT 10
+#define PREFERRED_DISTANCE 250
+
+// Most a candidate's score is nudged by at random when deciding
+#define SCORE_NOISE 4
+
+// Cpu player used by every world
+int cpu_player = DEFAULT_CPU;
+
+/* CPU SELECTION */
+
+// Choose which cpu player takeCPUAction uses
+void setCPUPlayer(int player)
+{
+    cpu_player = player;
+}
+
+// Get which cpu player takeCPUAction uses
+int getCPUPlayer()
+{
+    return cpu_player;
+}
+
+// Look up a cpu player by name, returning -1 if there's no such player
+int cpuByName(const char* name)
+{
+    if(!strcmp(name, "classic"))   return CPU_CLASSIC;
+    if(!strcmp(name, "lookahead")) return CPU_LOOKAHEAD;
+    return -1;
+}
+
+/* CLASSIC CPU */
+
+// Walk toward the other guy and cast at random
+static void takeClassicAction(World w, int cpu)
+{
+    // Opposing player
+    int player = !cpu;
+    int player_slot = guySlot(w, player);
+
+    // Cpu player
+    int cpu_slot = guySlot(w, cpu);
+
+    // Walk towards player, but maintain a healthy distance
+    int towards_player = w->active.x_pos[cpu_slot] < w->active.x_pos[player_slot];
+    if(fabs(w->active.x_pos[cpu_slot] - w->active.x_pos[player_slot]) >= 150) walk(w, cpu, towards_player);
+
+    // Generally face the player
+    if(w->active.action[cpu_slot] == IDLE) w->active.direction[cpu_slot] = towards_player;
+
+    // Randomly jump
+    if(get_rand(&w->rng, RNG_AI) <= 0.003) jump(w, cpu);
+
+    // Randomly cast spells
+    if(get_rand(&w->rng, RNG_AI) <= 0.015) cast(w, cpu, (int) (get_rand(&w->rng, RNG_AI) * NUM_SPELLS));
+}
+
+/* LOOKAHEAD CPU */
+
+// Face a cpu guy toward the other guy if he's standing around
+static void facePlayer(World w, int cpu)
+{
+    int i = guySlot(w, cpu);
+    int j = guySlot(w, !cpu);
+    if(w->active.action[i] == IDLE) w->active.direction[i] = w->active.x_pos[i] < w->active.x_pos[j];
+}
+
+// Make a cpu guy do an action, returning whether he could
+static bool doAction(World w, int cpu, int action)
+{
+    if(action < NUM_SPELLS) return cast(w, cpu, action);
+    if(action == CPU_JUMP)  return jump(w, cpu);
+    if(action == CPU_LEFT)  return walk(w, cpu, LEFT);
+    if(action == CPU_RIGHT) return walk(w, cpu, RIGHT);
+    return true;
+}
+
+// Score how things went for a cpu guy from one world to a later one, in which a guy may have died
+static double scoreOutcome(World before, World after, int cpu, int signal)
+{
+    if(signal == cpu + 1)  return -KO_SCORE;
+    if(signal == !cpu + 1) return KO_SCORE;
+    if(!overPlatform(after, cpu, getPlatforms(after))) return -KO_SCORE/2;
+    double dealt = getHealth(before, !cpu) - getHealth(after, !cpu);
+    double taken = getHealth(before, cpu) - getHealth(after, cpu);
+    double distance = fabs(after->active.x_pos[guySlot(after, cpu)] - after->active.x_pos[guySlot(after, !cpu)]);
+    return dealt - TAKEN_WEIGHT * taken - DISTANCE_WEIGHT * fabs(distance - PREFERRED_DISTANCE) / SCREEN_WIDTH;
+}
+
+// Try out an action for a cpu guy by simulating it ahead in the scratch world, returning its score
+// (or -HUGE_VAL if he can't do it right now)
+static double tryCandidate(World w, int cpu, int action)
+{
+    World sim = w->lookahead;
+    copyGameplay(sim, w);
+
+    // Walks are held for a while, and everything else is done once
+    facePlayer(sim, cpu);
+    if(!doAction(sim, cpu, action)) return -HUGE_VAL;
+    int signal = 0;
+    for(int f = 0; f < LOOKAHEAD_FRAMES && !signal; f++)
+    {
+        if(f && f < LOOKAHEAD_WALK_FRAMES && (action == CPU_LEFT || action == CPU_RIGHT)) doAction(sim, cpu, action);
+        signal = stepLookahead(sim);
+    }
+
+    double score = scoreOutcome(w, sim, cpu, signal);
+    if(action < NUM_SPELLS) score -= CAST_COST;
+    return score;
+}
+
+// Pick the best scoring candidate, with a little noise from the AI random stream so that ties are broken
+// and close calls go different ways from one game to the next
+static int bestCandidate(World w, const struct cpu_plan* plan)
+{
+    int best = CPU_WAIT;
+    double best_score = -HUGE_VAL;
+    double noise[NUM_CPU_ACTIONS];
+    fillRand(&w->rng, RNG_AI, noise, NUM_CPU_ACTIONS);
+    for(int a = 0; a < NUM_CPU_ACTIONS; a++)
+    {
+        double score = plan->scores[a] + SCORE_NOISE * noise[a];
+        if(score > best_score)
+        {
+            best = a;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+// Think a little further about what to do, and carry out the last decision
+static void takeLookaheadAction(World w, int cpu)
+{
+    // Try out the next few candidates, switching to the best one once they've all been tried
+    struct cpu_plan* plan = &w->plans[cpu];
+    for(int n = 0; n < LOOKAHEAD_PER_TICK; n++)
+    {
+        plan->scores[plan->next_candidate] = tryCandidate(w, cpu, plan->next_candidate);
+        if(++plan->next_candidate == NUM_CPU_ACTIONS)
+        {
+            plan->next_candidate = 0;
+            plan->action = bestCandidate(w, plan);
+        }
+    }
+
+    // Walks are kept up until the next decision, while a spell or a jump is only tried once
+    int action = plan->action;
+    if(action != CPU_LEFT && action != CPU_RIGHT) plan->action = CPU_WAIT;
+    facePlayer(w, cpu);
+    doAction(w, cpu, action);
+}
+
+/* PER FRAME UPDATES */
+
+// Process AI decisions for a cpu guy (guy 1 in 1-player mode, both guys when headless)
+void takeCPUAction(World w, int cpu)
+{
+    if(cpu_player == CPU_LOOKAHEAD) takeLookaheadAction(w, cpu);
+    else                            takeClassicAction(w, cpu);
+}
@@ -23,10 +23,21 @@ typedef struct menu_selection
     int mode_out;      // mode this option redirects to
 }* Selection;
 
+// Struct for a string rendered once into a texture of its own, so it can be drawn with one copy
+struct cached_text
+{
+    char text[MAX_CACHED_TEXT + 1]; // string rendered (empty if the entry is unused)
+    int align;                      // alignment the string was cached for
+    SDL_Texture* texture;           // texture the string is rendered into, at its left end (made once, when loading)
+    long long last_used;            // when the entry was last drawn, for choosing one to replace
+};
+
 SDL_Texture* toolbar;       // Texture containing all toolbar elements
 Tool* element_list;         // Array of all toolbar elements
 Selection* menu_selections; // Array containing locations and return values of select arrows
-int score = 0;              // The score, for 1-player games
+
+struct cached_text text_cache[TEXT_CACHE_SIZE]; // Strings rendered into textures of their own
+long long text_draws = 0;                       // Number of strings drawn through the text cache
 
 /* SETTERS */
 
@@ -74,39 +85,25 @@ int hover(int mode, int direction)
     return ret_val;
 }
 
-// Reset the score
-void setScore(int new_score)
-{
-    score = new_score;
-}
-
-// Add points to the score
-void updateScore(int points)
-{
-    score += points;
-}
-
 /* GETTERS */
 
-// Convert an integer score into a string readable by renderText
-static char* stringScore(int score)
+// Convert an integer score into a string readable by renderText, in a buffer of at least 7 chars
+static void stringScore(int score, char* str)
 {
     // Copy number into buffer
-    char* str = (char*) malloc(sizeof(char) * 7);
-    sprintf(str, "%06d", score);
+    sprintf(str, "%06d", score % 1000000);
 
     // Swap out zeros for the letter O
     for(int i = 0; i < 6; i++)
     {
         if(str[i] == '0') str[i] = 'O';
     }
-    return str;
 }
 
 /* ELEMENT RENDERING */
 
 // Render the guys' cooldown meters (alpha blended black bars)
-static void renderCooldowns(double* guy1_cds, double* guy2_cds)
+static void renderCooldowns(const double* guy1_cds, const double* guy2_cds)
 {
     // Starting location for cooldown meter
     Tool bar = element_list[COOLDOWN_BAR];
@@ -138,8 +135,8 @@ static void renderCooldowns(double* guy1_cds, double* guy2_cds)
     SDL_SetTextureAlphaMod(toolbar, 255);
 }
 
-// Render the guys' healthbars
-static void renderHealthbars(int guy1_hp, int guy2_hp)
+// Render the outlines of the guys' healthbars
+static void renderHealthbarOutlines(bool both_guys)
 {
     // Render guy 1 outline
     Tool hp_bar = element_list[HEALTH_BAR];
@@ -148,15 +145,20 @@ static void renderHealthbars(int guy1_hp, int guy2_hp)
     SDL_RenderCopy(renderer, toolbar, &clip, &renderQuad);
 
     // Render guy 2 outline if in VS mode
-    if(guy2_hp != -1)
+    if(both_guys)
     {
         renderQuad.x = SCREEN_WIDTH - hp_bar->width - (int)hp_bar->x;
         SDL_RenderCopy(renderer, toolbar, &clip, &renderQuad);
-        renderQuad.x = (int)hp_bar->x;
     }
+}
 
+// Render the guys' remaining health inside their healthbars (the outlines are part of the static layer, see layer.c)
+static void renderHealthbars(int guy1_hp, int guy2_hp)
+{
     // Render health remaining for Guy 1
-    clip.x += hp_bar->width;
+    Tool hp_bar = element_list[HEALTH_BAR];
+    SDL_Rect clip = {hp_bar->sheet_pos_x + hp_bar->width, hp_bar->sheet_pos_y, hp_bar->width, hp_bar->height};
+    SDL_Rect renderQuad = {(int)hp_bar->x, (int)hp_bar->y, hp_bar->width, hp_bar->height};
     clip.w = 25 + guy1_hp * 3;
     renderQuad.w = 25 + guy1_hp * 3;
     SDL_RenderCopy(renderer, toolbar, &clip, &renderQuad);
@@ -217,16 +219,10 @@ static void renderSelectionArrow(int mode, long long frame)
     SDL_RenderCopy(renderer, toolbar, &clip, &renderQuad);
 }
 
-// Render a piece of text to the screen
-static void renderText(const char* text, int x, int y, int align, int fade)
+// Render a piece of text from the font on the toolbar one letter at a time, starting at x
+static void renderLetters(const char* text, int len, int x, int y)
 {
-    // Set initial cursor position based on text align type
-    int len = (int) strlen(text);
     int cursor = x;
-    if(align == C) cursor = x - (len * FONT_SIZE / 2);
-
-    // Iterate over string
-    SDL_SetTextureAlphaMod(toolbar, fade);
     for(int i = 0; i < len; i++)
     {
         // ASCII shenanigans
@@ -245,13 +241,94 @@ static void renderText(const char* text, int x, int y, int align, int fade)
         SDL_RenderCopy(renderer, toolbar, &clip, &renderQuad);
         cursor += FONT_SIZE;
     }
+}
+
+// Render a string into a cache entry's texture, returning false if the entry has no texture to render into
+static bool bakeText(struct cached_text* entry, const char* text, int len, int align)
+{
+    // Text is drawn into the left end of the entry's texture, which is cleared to transparent first
+    if(!entry->texture) return false;
+    SDL_Texture* target = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, entry->texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+    // Letters are copied straight over, transparency and all, and the whole string is blended when drawn
+    SDL_BlendMode blend;
+    SDL_GetTextureBlendMode(toolbar, &blend);
+    SDL_SetTextureBlendMode(toolbar, SDL_BLENDMODE_NONE);
+    renderLetters(text, len, 0, 0);
+    SDL_SetTextureBlendMode(toolbar, blend);
+    SDL_SetRenderTarget(renderer, target);
+
+    // Replace whatever string the entry held before
+    entry->align = align;
+    memcpy(entry->text, text, len + 1);
+    return true;
+}
+
+// Find the cache entry for a string, rendering it into the least recently drawn entry if it isn't cached
+// (so a string that changes, like the score, only ever pushes out its own stale entries)
+static struct cached_text* findText(const char* text, int len, int align)
+{
+    struct cached_text* oldest = &text_cache[0];
+    for(int i = 0; i < TEXT_CACHE_SIZE; i++)
+    {
+        struct cached_text* entry = &text_cache[i];
+        if(entry->texture && entry->text[0] && entry->align == align && !strcmp(entry->text, text)) return entry;
+        if(entry->last_used < oldest->last_used) oldest = entry;
+    }
+    return bakeText(oldest, text, len, align) ? oldest : NULL;
+}
+
+// Render a piece of text to the screen
+static void renderText(const char* text, int x, int y, int align, int fade)
+{
+    // Set initial cursor position based on text align type
+    int len = (int) strlen(text);
+    int cursor = x;
+    if(align == C) cursor = x - (len * FONT_SIZE / 2);
+
+    // Draw the string with one copy if it's in the text cache (or can be put there)
+    struct cached_text* entry = len <= MAX_CACHED_TEXT ? findText(text, len, align) : NULL;
+    if(entry)
+    {
+        entry->last_used = ++text_draws;
+        SDL_Rect clip = {0, 0, len * FONT_SIZE, FONT_SIZE};
+        SDL_Rect renderQuad = {cursor, y, len * FONT_SIZE, FONT_SIZE};
+        SDL_SetTextureAlphaMod(entry->texture, fade);
+        SDL_RenderCopy(renderer, entry->texture, &clip, &renderQuad);
+        return;
+    }
+
+    // Otherwise draw it a letter at a time
+    SDL_SetTextureAlphaMod(toolbar, fade);
+    renderLetters(text, len, cursor, y);
     SDL_SetTextureAlphaMod(toolbar, 255);
 }
 
+// Drop every rendered string from the text cache, keeping the textures to render strings into again
+void clearTextCache()
+{
+    for(int i = 0; i < TEXT_CACHE_SIZE; i++)
+    {
+        text_cache[i].text[0] = '\0';
+        text_cache[i].last_used = 0;
+    }
+}
+
 /* PER FRAME UPDATE */
 
-// Render all of the current mode's toolbar and text elements to the screen
-void renderInterface(int mode, long long frame, int guy1_hp, int guy2_hp, double* guy1_cds, double* guy2_cds)
+// Render the parts of the given mode's interface that never change
+void renderChrome(int mode)
+{
+    if(mode == VS)                      renderHealthbarOutlines(true);
+    if(mode == AI || mode == PAUSE)     renderHealthbarOutlines(false);
+}
+
+// Render all of the given mode's toolbar and text elements to the screen
+void renderInterface(int mode, long long frame, int shown_score, int guy1_hp, int guy2_hp, const double* guy1_cds, const double* guy2_cds)
 {
     int alpha_max = 255;
     int x = SCREEN_WIDTH / 2;
@@ -313,25 +390,25 @@ void renderInterface(int mode, long long frame, int guy1_hp, int guy2_hp, double
         case AI:
         {
             int y = 25;
-            char* score_string = stringScore(score);
+            char score_string[7];
+            stringScore(shown_score, score_string);
             renderHealthbars(guy1_hp, -1);
             renderCooldowns(guy1_cds, NULL);
             renderText("SCORE",      600, y, L, alpha_max);
             renderText(score_string, 780, y, L, alpha_max);
-            free(score_string);
             break;
         }
 
         case PAUSE:
         {
             int y = 25;
-            char* score_string = stringScore(score);
+            char score_string[7];
+            stringScore(shown_score, score_string);
             renderHealthbars(guy1_hp, -1);
             renderCooldowns(guy1_cds, NULL);
             renderText("PAUSED",     x,   280, C, alpha_max);
             renderText("SCORE",      600, y,   L, alpha_max);
             renderText(score_string, 780, y,   L, alpha_max);
-            free(score_string);
             break;
         }
 
@@ -344,15 +421,13 @@ void renderInterface(int mode, long long frame, int guy1_hp, int guy2_hp, double
         case GAME_OVER_AI:
         {
             int y = 280;
-            char* score_string = stringScore(score);
+            char score_string[7];
+            stringScore(shown_score, score_string);
             renderText("GAME OVER",  x,       y,            C, alpha_max);
             renderText("SCORE",      x - 100, y + 2*margin, C, alpha_max);
             renderText(score_string, x + 80,  y + 2*margin, C, alpha_max);
-            free(score_string);
         }
     }
-    free(guy1_cds);
-    free(guy2_cds);
 }
 
 /* DATA ALLOCATION / INITIALIZATION */
@@ -399,11 +474,22 @@ void loadInterface()
     menu_selections[2] = initMenuOption(TITLE, CONTROLS, 370, 300 + (FONT_SIZE + 10) * 2);
     menu_selections[3] = initMenuOption(STAGE_SELECT, 0, 250, 120);
     menu_selections[4] = initMenuOption(STAGE_SELECT, 1, 250, 120 + FONT_SIZE + 10);
+
+    // Make a texture for each text cache entry, wide enough for the longest string, so that caching a string
+    // during play only draws into one (without render targets, text is drawn a letter at a time instead)
+    for(int i = 0; i < TEXT_CACHE_SIZE; i++)
+    {
+        text_cache[i] = (struct cached_text) {.texture = NULL};
+        if(!SDL_RenderTargetSupported(renderer)) continue;
+        text_cache[i].texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                                  MAX_CACHED_TEXT * FONT_SIZE, FONT_SIZE);
+        if(text_cache[i].texture) SDL_SetTextureBlendMode(text_cache[i].texture, SDL_BLENDMODE_BLEND);
+    }
 }
 
 /* DATA UNLOADING */
 
-// Free the toolbar elements, selection options, and toolbar texture from memory
+// Free the toolbar elements, selection options, cached text, and toolbar texture from memory
 void freeInterface()
 {
     for(int i = 0; i < NUM_ELEMENTS; i++) free(element_list[i]);
@@ -412,5 +498,10 @@ void freeInterface()
     for(int i = 0; i < NUM_MENU_OPTIONS; i++) free(menu_selections[i]);
     free(menu_selections);
 
+    for(int i = 0; i < TEXT_CACHE_SIZE; i++)
+    {
+        if(text_cache[i].texture) SDL_DestroyTexture(text_cache[i].texture);
+        text_cache[i].texture = NULL;
+    }
     SDL_DestroyTexture(toolbar);
 }
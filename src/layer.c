@@ -0,0 +1,81 @@
+#include "../headers/constants.h"
+#include "../headers/level.h"
+#include "../headers/interface.h"
+#include "../headers/layer.h"
+
+SDL_Texture* static_layer = NULL;   // Foreground and interface outlines, composited into one texture
+bool layer_valid = false;           // Whether the texture holds the layer for the level and mode below
+int layer_level = -1;               // Level the layer was composited for
+int layer_mode = -1;                // Game mode the layer was composited for
+
+/* COMPOSITING */
+
+// Draw everything that belongs on the static layer, straight to the current render target, or into the
+// layer's texture when compositing
+static void drawStaticPieces(int level, int mode, bool compositing)
+{
+    // The layer is blended when it's drawn, so the foreground goes into it unblended, or its partly
+    // transparent edges would be darkened by their alpha twice
+    if(compositing) copyForeground(level);
+    else            renderForeground(level);
+    renderChrome(mode);
+}
+
+// Composite the static layer for a level in a game mode into its texture, returning false if the renderer can't
+static bool buildStaticLayer(int level, int mode)
+{
+    // The layer covers the whole screen, starting out transparent
+    if(!SDL_RenderTargetSupported(renderer)) return false;
+    if(!static_layer)
+    {
+        static_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                         SCREEN_WIDTH, SCREEN_HEIGHT);
+        if(!static_layer) return false;
+        SDL_SetTextureBlendMode(static_layer, SDL_BLENDMODE_BLEND);
+    }
+    SDL_Texture* target = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, static_layer);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+
+    // The pieces go onto it in the order they'd be drawn to the screen
+    drawStaticPieces(level, mode, true);
+    SDL_SetRenderTarget(renderer, target);
+
+    layer_level = level;
+    layer_mode = mode;
+    layer_valid = true;
+    return true;
+}
+
+// Draw the static layer for a level in a game mode, rebuilding it first if either has changed
+void renderStaticLayer(int level, int mode)
+{
+    if(!layer_valid || level != layer_level || mode != layer_mode)
+    {
+        // Without a texture to composite into, draw the pieces one by one
+        if(!buildStaticLayer(level, mode))
+        {
+            drawStaticPieces(level, mode, false);
+            return;
+        }
+    }
+    SDL_RenderCopy(renderer, static_layer, NULL, NULL);
+}
+
+// Rebuild the static layer the next time it's drawn
+void invalidateStaticLayer()
+{
+    layer_valid = false;
+}
+
+/* DATA UNLOADING */
+
+// Free the static layer's texture
+void freeStaticLayer()
+{
+    if(static_layer) SDL_DestroyTexture(static_layer);
+    static_layer = NULL;
+    layer_valid = false;
+}
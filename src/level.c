@@ -1,6 +1,12 @@
 #include "../headers/constants.h"
 #include "../headers/sound.h"
 #include "../headers/level.h"
+#include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/world.h"
 
 // Struct for background information
 typedef struct background
@@ -14,13 +20,6 @@ typedef struct background
     double xv_init;             // initial x velocity
     double yv_init;             // initial y velocity
     int drift_type;             // how does this background move (SCROLL, DRIFT)
-
-    // State info about the background
-    double x;                   // current x position
-    double y;                   // current y position
-    double x_vel;               // current x velocity
-    double y_vel;               // current y velocity
-
 }* Background;
 
 // Struct for foreground information
@@ -39,36 +38,46 @@ enum drift_types
 Background* backgrounds = NULL; // Array of existing backgrounds
 Foreground* foregrounds = NULL; // Array of existing foregrounds
 
-int current_background = FOREST; // Current background
-int current_foreground = FOREST; // Current foreground
-
 /* SETTERS */
 
 // Switch the level to a new one
-void switchLevel(int new_level)
+void switchLevel(World w, int new_level)
 {
-    current_background = new_level;
-    current_foreground = new_level;
+    w->current_background = new_level;
+    w->current_foreground = new_level;
+}
+
+// Put every background of a world back where it starts
+void resetBackgrounds(World w)
+{
+    for(int i = 0; i < NUM_BACKGROUNDS; i++)
+    {
+        Background bg = backgrounds[i];
+        struct background_state* state = &w->background_states[i];
+        state->x = bg->x_init;          state->y = bg->y_init;
+        state->prev_x = bg->x_init;     state->prev_y = bg->y_init;
+        state->x_vel = bg->xv_init;     state->y_vel = bg->yv_init;
+    }
 }
 
 /* GETTERS */
 
 // Returns current level
-int getLevel()
+int getLevel(World w)
 {
-    return current_foreground;
+    return w->current_foreground;
 }
 
 // Returns the platforms on the current foreground
-int* getPlatforms()
+int* getPlatforms(World w)
 {
-    return foregrounds[current_foreground]->platforms;
+    return foregrounds[w->current_foreground]->platforms;
 }
 
 // Returns the walls on the current foreground
-int* getWalls()
+int* getWalls(World w)
 {
-    return foregrounds[current_foreground]->walls;
+    return foregrounds[w->current_foreground]->walls;
 }
 
 // Returns starting position of the guys on the current foreground
@@ -80,23 +89,26 @@ int* getStartingPositions(int fg)
 /* PER FRAME UPDATES */
 
 // Animate the background
-void moveBackground()
+void moveBackground(World w)
 {
     // Update position of the current background according to its velocity
-    Background bg = backgrounds[current_background];
+    Background meta = backgrounds[w->current_background];
+    struct background_state* bg = &w->background_states[w->current_background];
+    bg->prev_x = bg->x;
+    bg->prev_y = bg->y;
     bg->x += bg->x_vel;
     bg->y += bg->y_vel;
 
-    if(bg->drift_type == DRIFT)
+    if(meta->drift_type == DRIFT)
     {
         // Drifting backgrounds bounce when they reach the image's edge
         int reset_to = 0;
-        if(bg->x >= (reset_to = bg->width - SCREEN_WIDTH) || bg->x <= (reset_to = 0))
+        if(bg->x >= (reset_to = meta->width - SCREEN_WIDTH) || bg->x <= (reset_to = 0))
         {
             bg->x_vel *= -1;
             bg->x = reset_to;
         }
-        if(bg->y >= (reset_to = bg->height - SCREEN_HEIGHT) || bg->y <= (reset_to = 0))
+        if(bg->y >= (reset_to = meta->height - SCREEN_HEIGHT) || bg->y <= (reset_to = 0))
         {
             bg->y_vel *= -1;
             bg->y = reset_to;
@@ -105,40 +117,67 @@ void moveBackground()
     else
     {
         // Scrolling backgrounds reset so they appear to loop infinitely
-        if(bg->x >= bg->width || bg->x <= bg->width * -1) bg->x = 0;
+        // (the previous position moves with it, so the loop isn't visible when interpolating)
+        if(bg->x >= meta->width || bg->x <= meta->width * -1)
+        {
+            bg->prev_x -= bg->x;
+            bg->x = 0;
+        }
     }
 }
 
-// Render the current background
-static void renderBackground()
+// Capture everything needed to draw the current level
+void captureLevel(World w, struct level_view* view)
 {
-    // Draw the background at it's current position
-    Background bg = backgrounds[current_background];
-    SDL_Rect quad = {(int) bg->x * -1, (int) bg->y * -1, bg->width, bg->height};
+    const struct background_state* bg = &w->background_states[w->current_background];
+    view->level = w->current_foreground;
+    view->prev_x = bg->prev_x;
+    view->prev_y = bg->prev_y;
+    view->x = bg->x;
+    view->y = bg->y;
+}
+
+// Render a captured level's background
+static void renderBackground(const struct level_view* view, double alpha)
+{
+    // Draw the background between its previous and current positions
+    Background bg = backgrounds[view->level];
+    double x = lerp(view->prev_x, view->x, alpha);
+    double y = lerp(view->prev_y, view->y, alpha);
+    SDL_Rect quad = {(int) x * -1, (int) y * -1, bg->width, bg->height};
     SDL_RenderCopy(renderer, bg->image, NULL, &quad);
 
     // If the background scrolls, we may need to render it twice to create the illusion of looping
-    if(bg->drift_type == SCROLL && (bg->x + SCREEN_WIDTH > bg->width || bg->x < 0))
+    if(bg->drift_type == SCROLL && (x + SCREEN_WIDTH > bg->width || x < 0))
     {
-        quad.x = (int)bg->x * -1 + convert(bg->x > 0) * bg->width;
-        quad.y = (int)bg->y * -1;
+        quad.x = (int)x * -1 + convert(x > 0) * bg->width;
+        quad.y = (int)y * -1;
         quad.w = bg->width;
         quad.h = bg->height;
         SDL_RenderCopy(renderer, bg->image, NULL, &quad);
     }
 }
 
-// Render the current foreground
-static void renderForeground()
+// Render a captured level's background (its foreground is part of the static layer, see layer.c)
+void renderLevel(const struct level_view* view, double alpha)
 {
-    SDL_RenderCopy(renderer, foregrounds[current_foreground]->image, NULL, NULL);
+    renderBackground(view, alpha);
 }
 
-// Render the current level
-void renderLevel()
+// Render a level's foreground
+void renderForeground(int level)
 {
-    renderBackground();
-    renderForeground();
+    SDL_RenderCopy(renderer, foregrounds[level]->image, NULL, NULL);
+}
+
+// Copy the foreground over whatever is under it, alpha and all, rather than blending it in
+void copyForeground(int level)
+{
+    SDL_BlendMode blend;
+    SDL_GetTextureBlendMode(foregrounds[level]->image, &blend);
+    SDL_SetTextureBlendMode(foregrounds[level]->image, SDL_BLENDMODE_NONE);
+    SDL_RenderCopy(renderer, foregrounds[level]->image, NULL, NULL);
+    SDL_SetTextureBlendMode(foregrounds[level]->image, blend);
 }
 
 /* DATA ALLOCATION / INITIALIZATION */
@@ -153,17 +192,11 @@ static Background initBackground(const char* path, int drift, int w, int h, int
     // Assign positional data to the background
     this_background->width = w;     this_background->height = h;
     this_background->x_init = x;        this_background->y_init = y;
-    this_background->x = x;             this_background->y = y;
     this_background->xv_init = x_vel;   this_background->yv_init = y_vel;
-    this_background->x_vel = x_vel;     this_background->y_vel = y_vel;
 
     // Set up drifting/movement for this background
     this_background->drift_type = drift;
-    if(drift == SCROLL)
-    {
-        this_background->y_vel = 0;
-        this_background->yv_init = 0;
-    }
+    if(drift == SCROLL) this_background->yv_init = 0;
 
     // Return the new background struct
     return this_background;
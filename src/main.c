@@ -3,36 +3,119 @@
 #include "../headers/sprite.h"
 #include "../headers/level.h"
 #include "../headers/interface.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/simd.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/world.h"
+#include "../headers/profiler.h"
+#include "../headers/trace.h"
+#include "../headers/pacing.h"
+#include "../headers/batch.h"
+#include "../headers/audit.h"
+#include "../headers/layer.h"
+#include "../headers/replay.h"
+#include "../headers/tournament.h"
+#include "../headers/netplay.h"
 
-// Debug mode is off by default
+// Debug mode and headless mode are off by default
 bool debug = false;
+bool headless = false;
+
+// Frames are synced to the display's refresh rate unless turned off
+bool vsync = true;
+
+// The simulation runs on its own thread, while the main thread renders, unless turned off
+bool threaded = true;
 
 // Window and renderer, used by all modules
 SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
 
+// Actions a guy can take on a tick, as bits of an input mask (the spells come first, using the
+// spell identities, and guy 1's bits come after guy 0's)
+enum input_actions
+{ IN_JUMP = NUM_SPELLS, IN_LEFT, IN_RIGHT, NUM_INPUT_ACTIONS };
+
+// The bit of an input mask for a guy taking an action
+#define INPUT_BIT(guy, action) (1u << ((guy) * NUM_INPUT_ACTIONS + (action)))
+
+// Keys for each action (spells, jump, left, right), for each guy in 2-player mode, and in 1-player mode
+static const SDL_Scancode vs_keys[2][NUM_INPUT_ACTIONS] =
+{
+    {SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4, SDL_SCANCODE_5,
+     SDL_SCANCODE_D, SDL_SCANCODE_X, SDL_SCANCODE_V},
+    {SDL_SCANCODE_Y, SDL_SCANCODE_U, SDL_SCANCODE_I, SDL_SCANCODE_O, SDL_SCANCODE_P,
+     SDL_SCANCODE_UP, SDL_SCANCODE_LEFT, SDL_SCANCODE_RIGHT}
+};
+static const SDL_Scancode ai_keys[NUM_INPUT_ACTIONS] =
+{
+    SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4, SDL_SCANCODE_5,
+    SDL_SCANCODE_UP, SDL_SCANCODE_LEFT, SDL_SCANCODE_RIGHT
+};
+
+// Struct for everything needed to draw one frame, captured by the simulation after its last tick
+// (so the main thread can draw it while the simulation moves on)
+struct frame_view
+{
+    struct level_view level;                // background position and level
+    struct particle_view particles;         // live particles
+    struct sprite_view sprites;             // active sprites
+    int mode;                               // game mode
+    long long frame;                        // number of ticks simulated so far
+    int score;                              // score, for 1-player games
+    int hp[2];                              // health of each guy
+    double cooldowns[2][NUM_SPELLS + 1];    // cooldown percentages of each guy (ending with -1)
+    double alpha;                           // how far real time had gotten past the last tick
+};
+
+// Struct for a batch of simulation work, handed from the main thread to the simulation
+struct sim_job
+{
+    int ticks;                              // number of ticks to run
+    Uint32 input;                           // input mask applied on every tick
+    double alpha;                           // how far real time has gotten past the last tick
+    double budget;                          // particle budget for the ticks
+    Uint64 busy;                            // how long the batch took to run, in performance counter ticks
+    World world;                            // world the ticks are run in
+    struct frame_view* view;                // where to capture the result
+};
+
+struct frame_view views[2];                 // Frame being drawn, and frame being simulated
+struct sim_job job;                         // Batch of work for the simulation
+SDL_Thread* sim_thread = NULL;              // Thread the simulation runs on
+SDL_sem* job_ready = NULL;                  // Posted when the simulation has a batch of work
+SDL_sem* job_done = NULL;                   // Posted when the simulation has finished its batch
+bool sim_quit = false;                      // Tells the simulation thread to exit
+
 // Load SDL and initialize the window, renderer, audio, and data
 bool loadGame()
 {
-    // Initialize SDL
-    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) return false;
+    // Initialize SDL, without video or audio when headless
+    if(SDL_Init(headless ? 0 : SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) return false;
 
-    // Create window
-    window = SDL_CreateWindow("GUY BATTLE", 20, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
-    if(!window) return false;
+    if(!headless)
+    {
+        // Create window
+        window = SDL_CreateWindow("GUY BATTLE", 20, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+        if(!window) return false;
 
-    // Create renderer for window
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if(!renderer) return false;
+        // Create renderer for window
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+        if(!renderer) return false;
 
-    // Initialize renderer color and image loading
-    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        // Initialize renderer color and image loading
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    }
 
-    // Load level backgrounds and foregrounds
+    // Load level backgrounds and foregrounds (only terrain when headless)
     loadLevels();
 
-    // Load meta information for sprites
+    // Load meta information for sprites and particles
     loadSpriteInfo();
+    loadParticles();
+    if(headless) return true;
 
     // Load UI elements
     loadInterface();
@@ -43,27 +126,63 @@ bool loadGame()
     return true;
 }
 
-// Free all resources and quit SDL
-void quitGame()
+// Free the world and all resources, and quit SDL
+void quitGame(World w)
 {
+    // In debug mode, report how much of the sprite pool was needed so it can be sized per build,
+    // and how many sprite pairs the collision broadphase let through
+    if(debug)
+    {
+        long long possible, tested, hits;
+        getCollisionStats(w, &possible, &tested, &hits);
+        printf("Sprite pool high-water mark: %d / %d\n", getPoolHighWater(w), MAX_SPRITES);
+        printf("Sprite pairs: %lld possible, %lld tested, %lld hit\n", possible, tested, hits);
+        printf("Particle ring high-water marks:");
+        for(int id = FIRST_PARTICLE; id < FIRST_PARTICLE + NUM_PARTICLE_TYPES; id++)
+        {
+            printf(" %d", getParticleHighWater(w, id));
+        }
+        printf(" / %d\n", PARTICLE_CAPACITY);
+        printf("Lowest particle budget: %.0f%%\n", getLowestParticleBudget() * 100);
+        printf("Particle kernels: %s\n", getSIMDName());
+        printf("Random seed: %llu\n", (unsigned long long) getSeed(&w->rng));
+    }
+
+    // In verification mode, report whether the vector kernels ever disagreed with the scalar kernels
+    if(getSIMDVerify())
+    {
+        printf("SIMD verification (%s): %lld mismatches\n", getSIMDName(), getSIMDMismatches());
+    }
+
+    // Report any frames that allocated once warmed up
+    reportAudit();
+
+    // Leave the netplay game, if one was played
+    stopNetplay();
+
+    // Finish writing frame timings and the trace
+    closeProfiler();
+    if(!flushTrace()) fprintf(stderr, "Error: Could not write trace\n");
+
     // Free sprite metainfo
     freeSpriteInfo();
 
-    // Free remaining active sprites
-    freeActiveSprites();
+    // Free the world, and particle meta info
+    freeWorld(w);
+    freeParticles();
 
     // Free backgrounds and foregrounds
     freeLevels();
 
-    // Free UI elements
-    freeInterface();
-
-    // Free audio elements
-    freeSound();
-
-    // Free renderer and window
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
+    // Free UI elements, audio elements, renderer and window, which only exist with a display
+    if(!headless)
+    {
+        freeStaticLayer();
+        freeInterface();
+        freeSound();
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+    }
 
     // Free SDL
     SDL_Quit();
@@ -72,8 +191,11 @@ void quitGame()
 // Helper function to load an SDL texture
 SDL_Texture* loadTexture(const char* path)
 {
-    // Create a surface from path to bitmap file
+    // There is nothing to draw to when headless
     SDL_Texture* newTexture = NULL;
+    if(headless) return newTexture;
+
+    // Create a surface from path to bitmap file
     SDL_Surface* loaded = SDL_LoadBMP(path);
 
     // Create a texture from the surface
@@ -89,70 +211,658 @@ void setDebugMode()
 }
 
 // Helper function to cast a spell and update the score on success
-bool sCast(int guy, int spell)
+bool sCast(World w, int guy, int spell)
 {
-    bool succ = cast(guy, spell);
-    if(succ) updateScore(spell + 1);
+    bool succ = cast(w, guy, spell);
+    if(succ) updateScore(w, spell + 1);
     return succ;
 }
 
+// Read one guy's keys into an input mask (holding both left and right walks neither way)
+static Uint32 readKeys(int guy, const Uint8* keys, const SDL_Scancode* layout)
+{
+    Uint32 input = 0;
+    for(int a = 0; a < NUM_INPUT_ACTIONS; a++)
+    {
+        if(keys[layout[a]]) input |= INPUT_BIT(guy, a);
+    }
+    if((input & INPUT_BIT(guy, IN_LEFT)) && (input & INPUT_BIT(guy, IN_RIGHT)))
+    {
+        input &= ~(INPUT_BIT(guy, IN_LEFT) | INPUT_BIT(guy, IN_RIGHT));
+    }
+    return input;
+}
+
+// Read the keyboard into an input mask, using the key layout of the given mode (in a netplay game,
+// only this side's guy is read, with the 1-player keys)
+Uint32 readInput(int mode)
+{
+    const Uint8* keys = SDL_GetKeyboardState(NULL);
+    if(mode == VS && isNetplay()) return readKeys(getNetplayGuy(), keys, ai_keys);
+    if(mode == VS) return readKeys(0, keys, vs_keys[0]) | readKeys(1, keys, vs_keys[1]);
+    if(mode == AI) return readKeys(0, keys, ai_keys);
+    return 0;
+}
+
+// Make a guy act on an input mask: the last spell held is cast, otherwise he jumps, otherwise he walks
+// (casts are scored in 1-player games)
+static void applyInput(World w, int guy, Uint32 input, bool scored)
+{
+    bool succ = 0;
+    for(int spell = NUM_SPELLS - 1; !succ && spell >= 0; spell--)
+    {
+        if(input & INPUT_BIT(guy, spell)) succ = scored ? sCast(w, guy, spell) : cast(w, guy, spell);
+    }
+    if(!succ && (input & INPUT_BIT(guy, IN_JUMP)))  succ = jump(w, guy);
+    if(!succ && (input & INPUT_BIT(guy, IN_LEFT)))  succ = walk(w, guy, LEFT);
+    if(!succ && (input & INPUT_BIT(guy, IN_RIGHT))) succ = walk(w, guy, RIGHT);
+}
+
 // Helper function to set the level and teleport guys
-void setLevel(int level, int mode)
+void setLevel(World w, int level)
 {
-    switchLevel(level);
+    recordEvent(REPLAY_LEVEL, level);
+    switchLevel(w, level);
     int* starts = getStartingPositions(level);
-    resetGuy(0, starts[0], starts[1]);
-    resetGuy(1, starts[2], starts[3]);
+    resetGuy(w, 0, starts[0], starts[1]);
+    resetGuy(w, 1, starts[2], starts[3]);
+}
+
+// Run one simulation tick of the game in its current mode: the opening scene, player input, cpu decisions,
+// and the simulation itself
+void updateGame(World w, Uint32 input)
+{
+    // Delay the music starting a little bit because it's less jarring (and don't restart it when
+    // netplay simulates the frame again)
+    if(w->frame == 10 && !isResimulating()) startMusic();
+
+    // Immediately spawn guys and go to title in debug mode,
+    // otherwise guys spawn at specific points in opening scene
+    int f = w->frame, m = w->mode;
+    int* s = getStartingPositions(getLevel(w));
+    if((m == OPENING && f == 100) || (debug && f == 0)) spawnSprite(w, GUY, s[0], -100, 0, 0, RIGHT, 0, 0, 0);
+    if((m == OPENING && f == 225) || (debug && f == 0)) spawnSprite(w, GUY, s[2], -100, 0, 0, LEFT, 0, 0, 0);
+    if((m == OPENING && f == 375) || (debug && f == 0)) w->mode = TITLE;
+
+    if(w->mode != PAUSE)
+    {
+        // Act on the input for this tick
+        if(w->mode == VS)
+        {
+            applyInput(w, 0, input, false);
+            applyInput(w, 1, input, false);
+            markPhase(PHASE_INPUT);
+        }
+        else if(w->mode == AI)
+        {
+            applyInput(w, 0, input, true);
+            markPhase(PHASE_INPUT);
+
+            // Decisions for CPU Guy
+            takeCPUAction(w, 1);
+            markPhase(PHASE_AI);
+        }
+        else markPhase(PHASE_INPUT);
+
+        // Advance the simulation and check for dead guys
+        int signal = stepSimulation(w);
+        if(signal)
+        {
+            // In VS mode, if either guy dies, the game ends. In AI mode, if the cpu guy dies,
+            // a new guy is spawned and play continues.
+            if(w->mode == VS) w->mode = GAME_OVER_VS;
+            else if (signal == 1) w->mode = GAME_OVER_AI;
+            else
+            {
+                int* starts = getStartingPositions(getLevel(w));
+                resetGuy(w, 1, starts[2], -100);
+                updateScore(w, 100);
+            }
+        }
+    }
+    w->frame++;
+}
+
+// Make the changes a replay made between ticks, up to its next tick, and get that tick's input mask.
+// Returns false at the end of the replay
+static bool playReplayTick(World w, Uint32* input)
+{
+    int type, value;
+    while((type = readReplay(input, &value)) != REPLAY_TICK)
+    {
+        if(type == REPLAY_END) return false;
+        if(type == REPLAY_MODE)  w->mode = value;
+        if(type == REPLAY_LEVEL) setLevel(w, value);
+        if(type == REPLAY_SCORE) setScore(w, value);
+    }
+    return true;
+}
+
+// Report whether a replay that has been played back ended in the world it was recorded in
+static void reportReplay(long long frame, Uint64 hash)
+{
+    long long ticks;
+    Uint64 recorded;
+    getReplayEnd(&ticks, &recorded);
+    if(ticks < 0)            printf("Replay ended early, after %lld frames, with no world hash to check\n", frame);
+    else if(ticks != frame)  printf("Replay stopped after %lld of %lld frames\n", frame, ticks);
+    else if(hash == recorded) printf("Replay matches: %lld frames, world hash %016llx\n", frame, (unsigned long long) hash);
+    else printf("Replay DIVERGED: world hash %016llx, recorded %016llx\n", (unsigned long long) hash, (unsigned long long) recorded);
+    closeReplay();
+}
+
+// Capture everything needed to draw a frame
+static void captureFrame(World w, struct frame_view* view, double alpha)
+{
+    captureLevel(w, &view->level);
+    captureParticles(w, &view->particles);
+    captureSprites(w, &view->sprites);
+    view->mode = w->mode;
+    view->frame = w->frame;
+    view->score = getScore(w);
+    view->alpha = alpha;
+    for(int g = 0; g < 2; g++)
+    {
+        view->hp[g] = getHealth(w, g);
+        getCooldowns(w, g, view->cooldowns[g]);
+    }
+}
+
+// Draw a captured frame to the screen
+static void renderFrame(const struct frame_view* view)
+{
+    SDL_RenderClear(renderer);
+    renderLevel(&view->level, view->alpha);
+    renderStaticLayer(view->level.level, view->mode);
+    markPhase(PHASE_RENDER_LEVEL);
+
+    // Particles and sprites all come from the sprite sheet, so they're drawn in one batch
+    beginBatch(getSpriteSheet());
+    renderParticles(&view->particles, view->alpha);
+    markPhase(PHASE_RENDER_PARTICLES);
+    renderSprites(&view->sprites, view->alpha);
+    flushBatch();
+    markPhase(PHASE_RENDER_SPRITES);
+    renderInterface(view->mode, view->frame, view->score, view->hp[0], view->hp[1], view->cooldowns[0], view->cooldowns[1]);
+    markPhase(PHASE_RENDER_INTERFACE);
+}
+
+// Run a batch of simulation ticks, and capture the result for drawing
+static void runJob(struct sim_job* j)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    beginLane(LANE_SIMULATION);
+    setParticleBudget(j->world, j->budget);
+    for(int t = 0; t < j->ticks; t++)
+    {
+        // When playing back a replay, its input (and menu changes) replace the keyboard's
+        Uint32 input = j->input;
+        if(isReplaying() && !playReplayTick(j->world, &input)) break;
+        recordTick(input);
+        if(isNetplay()) playNetplayTick(j->world, input, updateGame);
+        else            updateGame(j->world, input);
+    }
+    captureFrame(j->world, j->view, j->alpha);
+    markPhase(PHASE_CAPTURE);
+    j->busy = SDL_GetPerformanceCounter() - start;
+}
+
+// Body of the simulation thread: run each batch of work as it's handed over, until told to quit
+static int simulationThread(void* data)
+{
+    while(true)
+    {
+        SDL_SemWait(job_ready);
+        if(sim_quit) return 0;
+        runJob(&job);
+        SDL_SemPost(job_done);
+    }
+}
+
+// Start the simulation thread, falling back to running the simulation on the main thread
+static void startSimulationThread()
+{
+    if(!threaded) return;
+    job_ready = SDL_CreateSemaphore(0);
+    job_done = SDL_CreateSemaphore(0);
+    if(job_ready && job_done) sim_thread = SDL_CreateThread(simulationThread, "simulation", NULL);
+    threaded = sim_thread != NULL;
+}
+
+// Stop the simulation thread (which must be idle)
+static void stopSimulationThread()
+{
+    if(sim_thread)
+    {
+        sim_quit = true;
+        SDL_SemPost(job_ready);
+        SDL_WaitThread(sim_thread, NULL);
+        sim_thread = NULL;
+    }
+    if(job_ready) SDL_DestroySemaphore(job_ready);
+    if(job_done) SDL_DestroySemaphore(job_done);
+    job_ready = job_done = NULL;
+}
+
+// Hand the current batch of work to the simulation (or run it now, if single threaded)
+static void startSimulation()
+{
+    if(threaded) SDL_SemPost(job_ready);
+    else         runJob(&job);
+}
+
+// Wait for the simulation thread to finish its batch of work, after which it's idle and the game state
+// can be touched by the main thread
+static void finishSimulation()
+{
+    SDL_SemWait(job_done);
+}
+
+// Run the simulation with no display as fast as possible, with the cpu controlling both guys,
+// and report how many frames were simulated per second
+void runHeadless(World w, long long frames)
+{
+    // Spawn both guys on the ground of the first level
+    int* starts = getStartingPositions(getLevel(w));
+    spawnSprite(w, GUY, starts[0], starts[1], 0, 0, RIGHT, 0, 0, 0);
+    spawnSprite(w, GUY, starts[2], starts[3], 0, 0, LEFT, 0, 0, 0);
+
+    // Whenever a guy dies, start a new round
+    long long rounds = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for(long long frame = 0; frame < frames; frame++)
+    {
+        beginFrame();
+        takeCPUAction(w, 0);
+        takeCPUAction(w, 1);
+        markPhase(PHASE_AI);
+        if(stepSimulation(w))
+        {
+            resetGuy(w, 0, starts[0], starts[1]);
+            resetGuy(w, 1, starts[2], starts[3]);
+            rounds++;
+        }
+        endFrame();
+        auditFrame();
+    }
+    double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+
+    printf("Simulated %lld frames (%lld rounds) in %.3f s: %.0f frames per second\n",
+           frames, rounds, seconds, frames / fmax(seconds, 1e-9));
+}
+
+// Play back a replay with no display as fast as possible, and report whether it ended in the world it was
+// recorded in
+void runReplay(World w)
+{
+    Uint32 input;
+    Uint64 start = SDL_GetPerformanceCounter();
+    while(playReplayTick(w, &input))
+    {
+        beginFrame();
+        updateGame(w, input);
+        endFrame();
+        auditFrame();
+    }
+    double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+
+    printf("Replayed %lld frames in %.3f s: %.0f frames per second\n", w->frame, seconds, w->frame / fmax(seconds, 1e-9));
+    reportReplay(w->frame, hashWorld(w));
 }
 
 // Helper function to reset the game to title screen
-void resetGame(int* mode, int* selection, int* vs_or_ai)
+void resetGame(World w, int* selection, int* vs_or_ai)
 {
-    *mode = TITLE;
+    w->mode = TITLE;
     *selection = VS;
     *vs_or_ai = VS;
-    setScore(0);
-    setLevel(FOREST, TITLE);
+    setScore(w, 0);
+    recordEvent(REPLAY_SCORE, 0);
+    setLevel(w, FOREST);
 }
 
 int main(int argc, char** argv)
 {
     // Parse command line arguments
-    if(argc > 1)
+    int simd_level = SIMD_AVX2;
+    bool verify_simd = false;
+    Uint64 seed = timeSeed();
+    long long headless_frames = HEADLESS_FRAMES;
+    const char* profile_csv = NULL;
+    const char* trace_path = NULL;
+    int pace_fps = 0;
+    bool audit_alloc = false;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    int tournament_matches = 0;
+    int tournament_threads = 0;
+    int cpu_player = DEFAULT_CPU;
+    int netplay_guy = 0;
+    int net_port = 0;
+    char peer_host[256] = "127.0.0.1";
+    int peer_port = 0;
+    int net_latency = 0;
+    int net_loss = 0;
+    for(int a = 1; a < argc; a++)
     {
-        if(!strcmp(argv[1], "-d") || !strcmp(argv[1], "--debug"))
+        if(!strcmp(argv[a], "-d") || !strcmp(argv[a], "--debug"))
         {
             setDebugMode();
             setMute();
         }
-        else if(!strcmp(argv[1], "-m") || !strcmp(argv[1], "--mute"))
+        else if(!strcmp(argv[a], "-m") || !strcmp(argv[a], "--mute"))
+        {
+            setMute();
+        }
+        else if((!strcmp(argv[a], "-b") || !strcmp(argv[a], "--broadphase")) && a + 1 < argc)
+        {
+            int method = broadphaseByName(argv[++a]);
+            if(method == -1)
+            {
+                printf("Unknown broadphase: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+            setBroadphase(method);
+        }
+        else if(!strcmp(argv[a], "--cpu") && a + 1 < argc)
+        {
+            cpu_player = cpuByName(argv[++a]);
+            if(cpu_player == -1)
+            {
+                printf("Unknown cpu player: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--simd") && a + 1 < argc)
+        {
+            simd_level = simdByName(argv[++a]);
+            if(simd_level == -1)
+            {
+                printf("Unknown instruction set: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--verify-simd"))
+        {
+            verify_simd = true;
+        }
+        else if((!strcmp(argv[a], "-s") || !strcmp(argv[a], "--seed")) && a + 1 < argc)
+        {
+            char* end;
+            seed = strtoull(argv[++a], &end, 0);
+            if(*end != '\0')
+            {
+                printf("Invalid seed: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--headless"))
+        {
+            headless = true;
+            setMute();
+        }
+        else if(!strcmp(argv[a], "--frames") && a + 1 < argc)
         {
+            char* end;
+            headless_frames = strtoll(argv[++a], &end, 10);
+            if(*end != '\0' || headless_frames < 0)
+            {
+                printf("Invalid frame count: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--no-vsync"))
+        {
+            vsync = false;
+        }
+        else if(!strcmp(argv[a], "--fps") && a + 1 < argc)
+        {
+            pace_fps = atoi(argv[++a]);
+            if(pace_fps <= 0)
+            {
+                printf("Invalid frame rate: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+            vsync = false;
+        }
+        else if(!strcmp(argv[a], "--no-batch"))
+        {
+            setBatching(false);
+        }
+        else if(!strcmp(argv[a], "--single-thread"))
+        {
+            threaded = false;
+        }
+        else if(!strcmp(argv[a], "--profile-csv") && a + 1 < argc)
+        {
+            profile_csv = argv[++a];
+        }
+        else if(!strcmp(argv[a], "--trace") && a + 1 < argc)
+        {
+            trace_path = argv[++a];
+        }
+        else if(!strcmp(argv[a], "--record") && a + 1 < argc)
+        {
+            record_path = argv[++a];
+        }
+        else if(!strcmp(argv[a], "--replay") && a + 1 < argc)
+        {
+            replay_path = argv[++a];
+        }
+        else if(!strcmp(argv[a], "--tournament") && a + 1 < argc)
+        {
+            char* end;
+            tournament_matches = strtol(argv[++a], &end, 10);
+            if(*end != '\0' || tournament_matches <= 0)
+            {
+                printf("Invalid match count: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+            headless = true;
             setMute();
         }
-        else if(!strcmp(argv[1], "-v") || !strcmp(argv[1], "--version"))
+        else if(!strcmp(argv[a], "--threads") && a + 1 < argc)
+        {
+            tournament_threads = atoi(argv[++a]);
+            if(tournament_threads <= 0 || tournament_threads > MAX_TOURNAMENT_THREADS)
+            {
+                printf("Invalid thread count: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--netplay") && a + 1 < argc)
+        {
+            netplay_guy = atoi(argv[++a]);
+            if(netplay_guy != 1 && netplay_guy != 2)
+            {
+                printf("Invalid guy: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--port") && a + 1 < argc)
+        {
+            net_port = atoi(argv[++a]);
+            if(net_port <= 0 || net_port > 65535)
+            {
+                printf("Invalid port: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--peer") && a + 1 < argc)
+        {
+            const char* colon = strrchr(argv[++a], ':');
+            int host_length = colon ? colon - argv[a] : 0;
+            if(colon) peer_port = atoi(colon + 1);
+            if(host_length <= 0 || host_length >= (int) sizeof(peer_host) || peer_port <= 0 || peer_port > 65535)
+            {
+                printf("Invalid peer: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+            snprintf(peer_host, sizeof(peer_host), "%.*s", host_length, argv[a]);
+        }
+        else if(!strcmp(argv[a], "--latency") && a + 1 < argc)
+        {
+            char* end;
+            net_latency = strtol(argv[++a], &end, 10);
+            if(*end != '\0' || net_latency < 0)
+            {
+                printf("Invalid latency: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--loss") && a + 1 < argc)
+        {
+            char* end;
+            net_loss = strtol(argv[++a], &end, 10);
+            if(*end != '\0' || net_loss < 0 || net_loss > 100)
+            {
+                printf("Invalid packet loss: %s\n", argv[a]);
+                printf("Use -h or --help to see a list of available options.\n");
+                return 0;
+            }
+        }
+        else if(!strcmp(argv[a], "--audit-alloc"))
+        {
+            audit_alloc = true;
+        }
+        else if(!strcmp(argv[a], "-v") || !strcmp(argv[a], "--version"))
         {
             printf("GUY_BATTLE 1.0.0\n");
             return 0;
         }
-        else if(!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))
+        else if(!strcmp(argv[a], "-h") || !strcmp(argv[a], "--help"))
         {
             printf("\nGUY_BATTLE 1.0.0\n\n");
             printf("Options\n");
             printf("----------------\n");
             printf("-d, --debug          run in debug mode\n");
             printf("-m, --mute           play with no sound effects or music\n");
+            printf("-b, --broadphase M   collision broadphase to use (brute, grid, sweep)\n");
+            printf("--cpu C              cpu player to play against (classic, lookahead)\n");
+            printf("--simd S             widest instruction set for particle updates (scalar, sse2, avx2)\n");
+            printf("--verify-simd        check particle updates against scalar code\n");
+            printf("-s, --seed N         seed for random numbers, to reproduce a game\n");
+            printf("--headless           simulate cpu vs cpu with no display, as fast as possible\n");
+            printf("--frames N           number of frames to simulate when headless\n");
+            printf("--no-vsync           render as many frames as possible instead of syncing to the display\n");
+            printf("--fps N              render at a steady N frames per second instead of syncing to the display\n");
+            printf("--single-thread      simulate and render on the same thread\n");
+            printf("--no-batch           draw sprites one at a time instead of in one batch\n");
+            printf("--profile-csv FILE   write the time spent in each phase of every frame to FILE\n");
+            printf("--trace FILE         write a Chrome trace of recent frames to FILE on exit\n");
+            printf("--record FILE        record the game to FILE, to be played back exactly\n");
+            printf("--replay FILE        play back a recorded game (as fast as possible with --headless)\n");
+            printf("--tournament N       play N cpu vs cpu matches with no display, and summarize the results\n");
+            printf("--threads N          number of threads to play a tournament on (one per core by default)\n");
+            printf("--netplay G          play VS over the network as guy G (1 or 2), against another copy of the game\n");
+            printf("--port N             UDP port to listen on for netplay (%d for guy 1, %d for guy 2 by default)\n", NETPLAY_PORT, NETPLAY_PORT + 1);
+            printf("--peer HOST:PORT     where the other guy is listening (127.0.0.1 and his default port by default)\n");
+            printf("--latency MS         delay every netplay packet sent by MS milliseconds, for testing\n");
+            printf("--loss P             drop P%% of netplay packets sent, for testing\n");
+            printf("--audit-alloc        log frames that allocate after warming up (needs an ALLOC_AUDIT build)\n");
             printf("-v, --version        print version information\n");
             printf("-h, --help           print help text\n\n");
             return 0;
         }
         else
         {
-            printf("Unknown option: %s\n", argv[1]);
+            printf("Unknown option: %s\n", argv[a]);
             printf("Use -h or --help to see a list of available options.\n");
             return 0;
         }
     }
 
+    // Count allocations from here on, so the frame loop can be checked for any
+    if(audit_alloc && !initAudit())
+    {
+        fprintf(stderr, "Error: Allocation auditing needs a build with ALLOC_AUDIT defined\n");
+        return 1;
+    }
+
+    // A tournament's matches are played on many threads at once, which the tools that record from
+    // the simulation (replays, traces, profiles, and SIMD verification) can't keep apart
+    if(tournament_matches && (record_path || replay_path || trace_path || profile_csv || verify_simd))
+    {
+        printf("A tournament can't be recorded, replayed, traced, profiled, or verified\n");
+        return 0;
+    }
+
+    // Both sides of a netplay game play VS from the start in step, which can't be done headless, or in
+    // debug mode (which changes the game), and the rollback would confuse a replay
+    if(netplay_guy && (headless || debug || record_path || replay_path))
+    {
+        printf("A netplay game can't be played headless, in debug mode, recorded, or replayed\n");
+        return 0;
+    }
+
+    // A replay is played with the seed, mode, and cpu player it was recorded with
+    if(replay_path)
+    {
+        if(record_path)
+        {
+            printf("A replay can't be recorded while another is played back\n");
+            return 0;
+        }
+        if(!openReplay(replay_path, &seed, &debug, &cpu_player))
+        {
+            fprintf(stderr, "Error: Could not read replay %s\n", replay_path);
+            return 1;
+        }
+    }
+    if(record_path && headless)
+    {
+        printf("Only games played with a display can be recorded\n");
+        return 0;
+    }
+    if(record_path && !startRecording(record_path, seed, debug, cpu_player))
+    {
+        fprintf(stderr, "Error: Could not open %s\n", record_path);
+        return 1;
+    }
+
+    // Choose the cpu player and the particle update kernels
+    setCPUPlayer(cpu_player);
+    initSIMD(simd_level, verify_simd);
+
+    // Record a timeline of frame phases and expensive handlers
+    if(trace_path && !initTrace(trace_path))
+    {
+        fprintf(stderr, "Error: Could not allocate trace buffer\n");
+        return 1;
+    }
+
+    // Time each phase of every frame, showing a breakdown in debug mode
+    if(!initProfiler(debug && !headless, profile_csv))
+    {
+        fprintf(stderr, "Error: Could not open %s\n", profile_csv);
+        return 1;
+    }
+
+    // Connect to the other side of a netplay game, which agrees on the seed (the first guy's is used)
+    if(netplay_guy)
+    {
+        if(!net_port)  net_port = NETPLAY_PORT + netplay_guy - 1;
+        if(!peer_port) peer_port = NETPLAY_PORT + 2 - netplay_guy;
+        printf("Waiting for guy %d at %s:%d...\n", 3 - netplay_guy, peer_host, peer_port);
+        if(!startNetplay(netplay_guy - 1, net_port, peer_host, peer_port, net_latency, net_loss, &seed))
+        {
+            fprintf(stderr, "Error: Could not connect to %s:%d\n", peer_host, peer_port);
+            return 1;
+        }
+    }
+
     // Load game
     if(!loadGame())
     {
@@ -160,44 +870,94 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    // Track what mode the game is in, and what menu selection is hovered
-    int mode = OPENING;
+    // Create the world the game is played in, with random numbers from the seed
+    World world = newWorld(seed);
+    if(!world)
+    {
+        fprintf(stderr, "Error: Could not allocate the world\n");
+        return 1;
+    }
+
+    // A netplay game goes straight to VS on the first level, with both guys on the ground
+    if(isNetplay())
+    {
+        int* starts = getStartingPositions(getLevel(world));
+        spawnSprite(world, GUY, starts[0], starts[1], 0, 0, RIGHT, 0, 0, 0);
+        spawnSprite(world, GUY, starts[2], starts[3], 0, 0, LEFT, 0, 0, 0);
+        world->mode = VS;
+    }
+
+    // Without a display, just run the simulation and quit
+    if(headless)
+    {
+        bool ok = true;
+        if(tournament_matches) ok = runTournament(tournament_matches, tournament_threads, seed);
+        else if(replay_path)   runReplay(world);
+        else                   runHeadless(world, headless_frames);
+        if(!ok) fprintf(stderr, "Error: Could not allocate the tournament\n");
+        quitGame(world);
+        return ok ? 0 : 1;
+    }
+
+    // Track what menu selection is hovered (the world tracks what mode the game is in, and how many
+    // frames have been simulated since the game started)
     int selection = VS;
     int vs_or_ai = VS;
 
-    // Track how many frames have passed since the game started
-    long long frame = 0;
+    // The simulation ticks at a fixed MAX_FPS (slowed down in debug mode), independent of the render rate,
+    // consuming the real time that has built up since the last frame
+    Uint64 tick_length = SDL_GetPerformanceFrequency() / MAX_FPS;
+    if(debug) tick_length *= 3;
+    Uint64 lag = tick_length;
+    Uint64 last_time = SDL_GetPerformanceCounter();
+
+    // Hold frames to a steady rate when one was asked for
+    initPacing(pace_fps);
+
+    // Simulate on a separate thread if there's a core to spare, drawing each frame while the next
+    // one is simulated. The starting state is captured so there's something to draw at first
+    if(SDL_GetCPUCount() < 2) threaded = false;
+    startSimulationThread();
+    int front = 0;
+    captureFrame(world, &views[front], 0);
+
+    // Cosmetic particles are cut back when the busiest thread's share of the frame deadline (the paced
+    // frame rate's, or MAX_FPS's) gets high, smoothed over recent frames
+    Uint64 deadline = SDL_GetPerformanceFrequency() / (pace_fps ? pace_fps : MAX_FPS);
+    double load = 0;
+    double budget = 1;
 
     // Game loop
     bool quit = false;
     SDL_Event e;
+    beginFrame();
     while(!quit)
     {
-        // Track how long this frame takes
-        int start_time = SDL_GetTicks();
-
-        // Delay the music starting a little bit because it's less jarring
-        if(frame == 10) startMusic();
+        // Add the time since the last frame to the simulation's backlog, dropping time after a long stall
+        Uint64 now = SDL_GetPerformanceCounter();
+        lag += now - last_time;
+        if(lag > MAX_TICKS_PER_FRAME * tick_length) lag = MAX_TICKS_PER_FRAME * tick_length;
+        last_time = now;
 
-        // Immediately spawn guys and go to title in debug mode,
-        // otherwise guys spawn at specific points in opening scene
-        int f = frame, m = mode;
-        int* s = getStartingPositions(getLevel());
-        if((m == OPENING && f == 100) || (debug && f == 0)) spawnSprite(GUY, s[0], -100, 0, 0, RIGHT, 0, 0, 0);
-        if((m == OPENING && f == 225) || (debug && f == 0)) spawnSprite(GUY, s[2], -100, 0, 0, LEFT, 0, 0, 0);
-        if((m == OPENING && f == 375) || (debug && f == 0)) mode = TITLE;
-
-        // Process any SDL events that have happened since last frame
+        // Process any SDL events that have happened since last frame (recording any change of mode they make)
+        int old_mode = world->mode;
         while(SDL_PollEvent(&e) != 0)
         {
             // No need to process further events if an exit signal was received
             if(e.type == SDL_QUIT) quit = true;
 
-            // Process key presses as game mode changes / menu selections
-            if(e.type == SDL_KEYDOWN)
+            // Textures drawn into by the renderer lose their contents when it's reset, so render them again
+            if(e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET)
+            {
+                clearTextCache();
+                invalidateStaticLayer();
+            }
+
+            // Process key presses as game mode changes / menu selections (a replay makes its own)
+            if(e.type == SDL_KEYDOWN && !isReplaying())
             {
                 int key = e.key.keysym.sym;
-                switch(mode)
+                switch(world->mode)
                 {
                     case TITLE:
                         // Select VS, AI, or controls and hit enter
@@ -205,23 +965,23 @@ int main(int argc, char** argv)
                         {
                             if(selection == CONTROLS)
                             {
-                                mode = selection;
+                                world->mode = selection;
                                 playSoundEffect(SFX_SELECT);
                             }
                             else
                             {
-                                mode = STAGE_SELECT;
+                                world->mode = STAGE_SELECT;
                                 vs_or_ai = selection;
                                 playSoundEffect(SFX_SELECT);
                             }
                         }
                         else if(key == SDLK_UP)
                         {
-                            selection = hover(mode, UP);
+                            selection = hover(world->mode, UP);
                         }
                         else if(key == SDLK_DOWN)
                         {
-                            selection = hover(mode, DOWN);
+                            selection = hover(world->mode, DOWN);
                         }
                         break;
 
@@ -229,23 +989,23 @@ int main(int argc, char** argv)
                         // Select Volcano or Forest and hit enter, or esc to title
                         if(key == SDLK_RETURN)
                         {
-                            mode = vs_or_ai;
+                            world->mode = vs_or_ai;
                             playSoundEffect(SFX_SELECT);
                         }
                         else if(key == SDLK_ESCAPE)
                         {
-                            resetGame(&mode, &selection, &vs_or_ai);
+                            resetGame(world, &selection, &vs_or_ai);
                             playSoundEffect(SFX_BACK);
                         }
                         else if(key == SDLK_UP)
                         {
-                            selection = hover(mode, UP);
-                            if(getLevel() != selection) setLevel(FOREST, vs_or_ai);
+                            selection = hover(world->mode, UP);
+                            if(getLevel(world) != selection) setLevel(world, FOREST);
                         }
                         else if(key == SDLK_DOWN)
                         {
-                            selection = hover(mode, DOWN);
-                            if(getLevel() != selection) setLevel(VOLCANO, vs_or_ai);
+                            selection = hover(world->mode, DOWN);
+                            if(getLevel(world) != selection) setLevel(world, VOLCANO);
                         }
                         break;
 
@@ -253,7 +1013,7 @@ int main(int argc, char** argv)
                         // Hit esc to pause during single player
                         if(key == SDLK_ESCAPE)
                         {
-                            mode = PAUSE;
+                            world->mode = PAUSE;
                             playSoundEffect(SFX_SELECT);
                         }
                         break;
@@ -262,7 +1022,7 @@ int main(int argc, char** argv)
                         // Hit esc or enter to leave controls page
                         if(key == SDLK_ESCAPE || key == SDLK_RETURN)
                         {
-                            mode = TITLE;
+                            world->mode = TITLE;
                             playSoundEffect(SFX_BACK);
                         }
                         break;
@@ -271,17 +1031,21 @@ int main(int argc, char** argv)
                         // Hit esc or enter to unpause while paused
                         if(key == SDLK_ESCAPE || key == SDLK_RETURN)
                         {
-                            mode = AI;
+                            world->mode = AI;
                             playSoundEffect(SFX_BACK);
                         }
                         break;
 
                     case GAME_OVER_VS:
                     case GAME_OVER_AI:
-                        // Hit esc or enter to return to the title screen
-                        if(key == SDLK_ESCAPE || key == SDLK_RETURN)
+                        // Hit esc or enter to return to the title screen (or to leave a netplay game)
+                        if((key == SDLK_ESCAPE || key == SDLK_RETURN) && isNetplay())
+                        {
+                            quit = true;
+                        }
+                        else if(key == SDLK_ESCAPE || key == SDLK_RETURN)
                         {
-                            resetGame(&mode, &selection, &vs_or_ai);
+                            resetGame(world, &selection, &vs_or_ai);
                             playSoundEffect(SFX_BACK);
                         }
                         break;
@@ -292,105 +1056,84 @@ int main(int argc, char** argv)
                 }
             }
         }
+        if(world->mode != old_mode) recordEvent(REPLAY_MODE, world->mode);
+        markPhase(PHASE_EVENTS);
 
-        if(mode != PAUSE)
+        // Run as many fixed-length simulation ticks as real time has built up, and capture how far
+        // real time has gotten between the last tick and the next one
+        job.ticks = 0;
+        while(lag >= tick_length)
         {
-            // Process key presses as actions in battle
-            const Uint8* keys = SDL_GetKeyboardState(NULL);
-            bool succ = 0;
-            int guy = 0;
-            if(mode == VS)
-            {
-                // Input for guy 0
-                if(!succ && keys[SDL_SCANCODE_5])                          succ = cast(guy, ARCSURGE);
-                if(!succ && keys[SDL_SCANCODE_4])                          succ = cast(guy, DARKEDGE);
-                if(!succ && keys[SDL_SCANCODE_3])                          succ = cast(guy, ROCKFALL);
-                if(!succ && keys[SDL_SCANCODE_2])                          succ = cast(guy, ICESHOCK);
-                if(!succ && keys[SDL_SCANCODE_1])                          succ = cast(guy, FIREBALL);
-                if(!succ && keys[SDL_SCANCODE_D])                          succ = jump(guy);
-                if(!succ && keys[SDL_SCANCODE_X] && !keys[SDL_SCANCODE_V]) succ = walk(guy, LEFT);
-                if(!succ && keys[SDL_SCANCODE_V] && !keys[SDL_SCANCODE_X]) succ = walk(guy, RIGHT);
-
-                // Input for guy 1
-                succ = 0;
-                guy = 1;
-                if(!succ && keys[SDL_SCANCODE_P])                                 succ = cast(guy, ARCSURGE);
-                if(!succ && keys[SDL_SCANCODE_O])                                 succ = cast(guy, DARKEDGE);
-                if(!succ && keys[SDL_SCANCODE_I])                                 succ = cast(guy, ROCKFALL);
-                if(!succ && keys[SDL_SCANCODE_U])                                 succ = cast(guy, ICESHOCK);
-                if(!succ && keys[SDL_SCANCODE_Y])                                 succ = cast(guy, FIREBALL);
-                if(!succ && keys[SDL_SCANCODE_UP])                                succ = jump(guy);
-                if(!succ && keys[SDL_SCANCODE_LEFT] && !keys[SDL_SCANCODE_RIGHT]) succ = walk(guy, LEFT);
-                if(!succ && keys[SDL_SCANCODE_RIGHT] && !keys[SDL_SCANCODE_LEFT]) succ = walk(guy, RIGHT);
-            }
-            else if(mode == AI)
-            {
-                // Input for guy 0
-                if(!succ && keys[SDL_SCANCODE_5])                                 succ = sCast(guy, ARCSURGE);
-                if(!succ && keys[SDL_SCANCODE_4])                                 succ = sCast(guy, DARKEDGE);
-                if(!succ && keys[SDL_SCANCODE_3])                                 succ = sCast(guy, ROCKFALL);
-                if(!succ && keys[SDL_SCANCODE_2])                                 succ = sCast(guy, ICESHOCK);
-                if(!succ && keys[SDL_SCANCODE_1])                                 succ = sCast(guy, FIREBALL);
-                if(!succ && keys[SDL_SCANCODE_UP])                                succ = jump(guy);
-                if(!succ && keys[SDL_SCANCODE_LEFT] && !keys[SDL_SCANCODE_RIGHT]) succ = walk(guy, LEFT);
-                if(!succ && keys[SDL_SCANCODE_RIGHT] && !keys[SDL_SCANCODE_LEFT]) succ = walk(guy, RIGHT);
-
-                // Decisions for CPU Guy
-                takeCPUAction();
-            }
+            lag -= tick_length;
+            job.ticks++;
+        }
+        job.alpha = (double) lag / tick_length;
+        job.input = readInput(world->mode);
+        job.world = world;
+        job.view = &views[!front];
+        job.budget = budget;
+        startSimulation();
 
-            // Move the background
-            moveBackground();
+        // When single threaded the batch is already done, and its frame is drawn right away.
+        // Otherwise the last finished frame is drawn while the simulation works
+        if(!threaded)
+        {
+            front = !front;
+        }
+        Uint64 render_start = SDL_GetPerformanceCounter();
+        renderFrame(&views[front]);
 
-            // Update positions, velocities, and orientations of all sprites
-            moveSprites();
+        // The debug meters are drawn last, and counted as part of presenting the frame
+        // (with vsync on, presenting waits for the display, which paces the render rate)
+        if(debug) renderParticleBudget(budget);
+        renderProfile();
+        Uint64 render_busy = SDL_GetPerformanceCounter() - render_start;
+        SDL_RenderPresent(renderer);
+        markPhase(PHASE_PRESENT);
 
-            // Check for and handle collisions with terrain or other sprites
-            terrainCollisions(getPlatforms(), getWalls());
-            spriteCollisions();
+        // Wait for the next frame's start time (when pacing), and measure the frame
+        waitForNextFrame();
+        markPhase(PHASE_SLEEP);
 
-            // Spawn any new spells that people are casting
-            launchSpells();
+        // Wait for the simulation to finish, so its frame is drawn next
+        if(threaded)
+        {
+            finishSimulation();
+            front = !front;
+        }
+        markPhase(PHASE_WAIT);
 
-            // Update values on timed sprite variables (spell cooldowns, casting / collision durations, etc)
-            advanceTimers();
+        // Stop once a replay has been played to the end
+        if(replay_path && !isReplaying()) quit = true;
 
-            // Unload dead sprites and check for dead guys
-            int signal = unloadSprites();
-            if(signal)
-            {
-                // In VS mode, if either guy dies, the game ends. In AI mode, if the cpu guy dies,
-                // a new guy is spawned and play continues.
-                if(mode == VS) mode = GAME_OVER_VS;
-                else if (signal == 1) mode = GAME_OVER_AI;
-                else
-                {
-                    int* starts = getStartingPositions(getLevel());
-                    resetGuy(1, starts[2], -100);
-                    updateScore(100);
-                }
-            }
-
-            // Update the animation frame which is drawn for all sprites
-            updateAnimationFrames();
+        // Stop once the other side of a netplay game has left or gone quiet
+        if(isNetplay() && !isNetplayConnected())
+        {
+            printf("The other side of the netplay game has left\n");
+            quit = true;
         }
 
-        // Render changes to screen
-        SDL_RenderClear(renderer);
-        renderLevel();
-        renderSprites();
-        renderInterface(mode, frame, getHealth(0), getHealth(1), getCooldowns(0), getCooldowns(1));
-        SDL_RenderPresent(renderer);
-
-        // Cap framerate at MAX_FPS
-        double ms_per_frame = 1000.0 / MAX_FPS;
-        if(debug) ms_per_frame *= 3;
-        int sleep_time = ms_per_frame - (SDL_GetTicks() - start_time);
-        if(sleep_time > 0) SDL_Delay(sleep_time);
-        frame++;
+        // Adjust the particle budget to how much of the deadline this frame's work took (drawing and
+        // simulating overlap when threaded), and how many particles are live
+        Uint64 busy = threaded ? (job.busy > render_busy ? job.busy : render_busy) : job.busy + render_busy;
+        load = 0.9 * load + 0.1 * busy / (double) deadline;
+        int live = 0;
+        for(int t = 0; t < NUM_PARTICLE_TYPES; t++) live += views[front].particles.count[t];
+        budget = nextParticleBudget(budget, load, live);
+        endFrame();
+        auditFrame();
+        beginFrame();
     }
+    stopSimulationThread();
+
+    // Finish the replay being recorded, or check the one played back, with the world the game ended in
+    if(!finishRecording(hashWorld(world))) fprintf(stderr, "Error: Could not write %s\n", record_path);
+    if(replay_path) reportReplay(world->frame, hashWorld(world));
+
+    // Report how steady the frame rate was
+    if(debug || pace_fps) reportFrameTimes();
 
     // Free all resources and exit game
-    quitGame();
+    quitGame(world);
     return 0;
 }
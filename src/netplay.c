@@ -0,0 +1,504 @@
+// Sockets are POSIX, not C99
+#define _POSIX_C_SOURCE 200112L
+
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/level.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/world.h"
+#include "../headers/netplay.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Identifies a netplay packet ("GBNP")
+#define NET_MAGIC 0x504E4247u
+
+// Kinds of packet: a greeting while connecting, inputs during the game, and a goodbye
+enum net_packets
+{ NET_HELLO, NET_INPUT, NET_BYE };
+
+// Most inputs a packet carries, and the biggest a packet can be
+#define NET_MAX_INPUTS 64
+#define NET_PACKET_SIZE (40 + 4 * NET_MAX_INPUTS)
+
+// Frames of inputs kept, which must cover every frame either side hasn't confirmed yet
+#define NET_INPUT_RING 128
+
+// Most packets that can be held back for artificial latency at once
+#define NET_QUEUE_SIZE 256
+
+// Worlds saved, one from before each frame that may have to be simulated again
+#define NET_SAVES (NETPLAY_MAX_PREDICTION + 1)
+
+// World hashes kept for comparing with the peer's, and how often a side that's ahead may skip a tick
+#define NET_CHECKS 4
+#define NET_SYNC_INTERVAL 20
+
+// How often a greeting is sent while connecting, in milliseconds
+#define NET_HELLO_INTERVAL 100
+
+// Struct for a packet being held back to simulate latency
+struct net_packet
+{
+    Uint32 due;                             // when the packet is sent (SDL_GetTicks time)
+    int size;                               // number of bytes in the packet
+    Uint8 bytes[NET_PACKET_SIZE];           // the packet
+};
+
+int net_socket = -1;                        // UDP socket, or -1 when no netplay game is being played
+struct sockaddr_in peer_address;            // where the other side is listening
+int local_guy = 0;                          // which guy is controlled on this side
+int net_latency = 0;                        // delay added to every packet sent, in milliseconds
+double net_loss = 0;                        // fraction of packets sent that are dropped on purpose
+struct rng_state net_rng;                   // random numbers for dropping packets, kept out of every world
+struct net_packet send_queue[NET_QUEUE_SIZE];   // packets held back for artificial latency, oldest first
+int queue_head = 0;                         // oldest packet in the queue
+int queue_count = 0;                        // number of packets in the queue
+
+Uint32 local_inputs[NET_INPUT_RING];        // this side's input mask for each frame
+Uint32 remote_inputs[NET_INPUT_RING];       // the other side's input mask for each frame, once it's known
+Uint32 predicted[NET_INPUT_RING];           // the other side's input mask each frame was last simulated with
+int net_frame = 0;                          // next frame to be simulated
+int local_frame = 0;                        // last frame this side's input is known for
+int remote_frame = -1;                      // last frame the other side's input is known for (and every one before)
+int mispredicted = -1;                      // earliest frame simulated with a wrong prediction, or -1
+int peer_ack = -1;                          // last frame the other side has all of this side's inputs up to
+int peer_frame = 0;                         // next frame the other side was going to simulate, as last heard
+int peer_lead = 0;                          // how far the other side was ahead of what it had heard from this side
+int last_skip = 0;                          // frame at which a tick was last skipped to let the other side catch up
+struct world* saves = NULL;                 // the world as it was before each of the last NET_SAVES frames
+bool resimulating = false;                  // whether frames are being simulated again
+Uint32 last_heard = 0;                      // when the other side was last heard from (SDL_GetTicks time)
+bool peer_left = false;                     // whether the other side has said goodbye
+
+int check_frames[NET_CHECKS];               // recent frames the world was hashed after on this side
+Uint64 check_hashes[NET_CHECKS];            // the hash of the world after each of those frames
+int next_check = NETPLAY_CHECK_INTERVAL;    // next frame to hash the world after
+int latest_check = -1;                      // last frame hashed, which is sent to the other side
+int peer_check = -1;                        // last frame the other side hashed
+Uint64 peer_hash = 0;                       // the other side's hash of the world after that frame
+int compared_check = -1;                    // last frame whose hashes have been compared
+
+long long rollbacks = 0;                    // number of times the world was rolled back
+long long resimulated = 0;                  // number of frames simulated again
+int deepest_rollback = 0;                   // most frames simulated again at once
+long long stalls = 0;                       // ticks skipped for having predicted too far ahead
+long long skips = 0;                        // ticks skipped to let the other side catch up
+int checks_matched = 0;                     // world hashes that matched the other side's
+int checks_differed = 0;                    // world hashes that didn't
+
+/* PACKETS */
+
+// Write a 32-bit value into a packet, lowest byte first, returning where the next value goes
+static Uint8* putWord(Uint8* p, Uint32 n)
+{
+    for(int i = 0; i < 4; i++) *p++ = (n >> (8 * i)) & 0xFF;
+    return p;
+}
+
+// Write a 64-bit value into a packet, lowest byte first
+static Uint8* putWide(Uint8* p, Uint64 n)
+{
+    for(int i = 0; i < 8; i++) *p++ = (n >> (8 * i)) & 0xFF;
+    return p;
+}
+
+// Read a 32-bit value written by putWord, returning where the next value is
+static const Uint8* getWord(const Uint8* p, Uint32* n)
+{
+    *n = 0;
+    for(int i = 0; i < 4; i++) *n |= (Uint32) *p++ << (8 * i);
+    return p;
+}
+
+// Read a 64-bit value written by putWide
+static const Uint8* getWide(const Uint8* p, Uint64* n)
+{
+    *n = 0;
+    for(int i = 0; i < 8; i++) *n |= (Uint64) *p++ << (8 * i);
+    return p;
+}
+
+// Send a packet to the peer right away
+static void sendNow(const Uint8* bytes, int size)
+{
+    sendto(net_socket, bytes, size, 0, (struct sockaddr*) &peer_address, sizeof(peer_address));
+}
+
+// Send a packet to the peer, dropping it or holding it back as the artificial loss and latency say
+static void sendPacket(const Uint8* bytes, int size)
+{
+    if(net_loss > 0 && get_rand(&net_rng, RNG_COSMETIC) < net_loss) return;
+    if(!net_latency)
+    {
+        sendNow(bytes, size);
+        return;
+    }
+
+    // A full queue drops the packet, like a congested link would
+    if(queue_count == NET_QUEUE_SIZE) return;
+    struct net_packet* packet = &send_queue[(queue_head + queue_count++) % NET_QUEUE_SIZE];
+    packet->due = SDL_GetTicks() + net_latency;
+    packet->size = size;
+    memcpy(packet->bytes, bytes, size);
+}
+
+// Send every held back packet whose delay is up
+static void flushQueue()
+{
+    Uint32 now = SDL_GetTicks();
+    while(queue_count && (Sint32) (now - send_queue[queue_head].due) >= 0)
+    {
+        sendNow(send_queue[queue_head].bytes, send_queue[queue_head].size);
+        queue_head = (queue_head + 1) % NET_QUEUE_SIZE;
+        queue_count--;
+    }
+}
+
+// Receive the next packet from the peer, returning its kind, or -1 if there are none waiting
+static int receivePacket(Uint8* bytes, int* size)
+{
+    while(true)
+    {
+        struct sockaddr_in from;
+        socklen_t from_size = sizeof(from);
+        ssize_t received = recvfrom(net_socket, bytes, NET_PACKET_SIZE, 0, (struct sockaddr*) &from, &from_size);
+        if(received < 0) return -1;
+
+        // Ignore anything that isn't a netplay packet from the peer
+        Uint32 magic;
+        if(received < 5) continue;
+        if(from.sin_addr.s_addr != peer_address.sin_addr.s_addr || from.sin_port != peer_address.sin_port) continue;
+        getWord(bytes, &magic);
+        if(magic != NET_MAGIC) continue;
+
+        last_heard = SDL_GetTicks();
+        *size = (int) received;
+        return bytes[4];
+    }
+}
+
+// Greet the peer, saying whether it has been heard from yet, with the seed this side would play with
+static void sendHello(bool heard, Uint64 seed)
+{
+    Uint8 bytes[NET_PACKET_SIZE];
+    Uint8* p = putWord(bytes, NET_MAGIC);
+    *p++ = NET_HELLO;
+    *p++ = local_guy;
+    *p++ = heard;
+    p = putWide(p, seed);
+    sendPacket(bytes, p - bytes);
+}
+
+// Send the peer every input it doesn't have yet (up to as many as fit), along with what this side has
+// heard, how far it has gotten, and its latest world hash
+static void sendInputs()
+{
+    int first = peer_ack + 1;
+    if(first < local_frame - NET_MAX_INPUTS + 1) first = local_frame - NET_MAX_INPUTS + 1;
+    int count = local_frame - first + 1;
+    if(count < 0) count = 0;
+
+    Uint8 bytes[NET_PACKET_SIZE];
+    Uint8* p = putWord(bytes, NET_MAGIC);
+    *p++ = NET_INPUT;
+    p = putWord(p, (Uint32) remote_frame);
+    p = putWord(p, (Uint32) net_frame);
+    p = putWord(p, (Uint32) (net_frame - peer_frame));
+    p = putWord(p, (Uint32) latest_check);
+    p = putWide(p, latest_check >= 0 ? check_hashes[(latest_check / NETPLAY_CHECK_INTERVAL) % NET_CHECKS] : 0);
+    p = putWord(p, (Uint32) first);
+    *p++ = count;
+    for(int f = first; f < first + count; f++) p = putWord(p, local_inputs[f % NET_INPUT_RING]);
+    sendPacket(bytes, p - bytes);
+}
+
+// Take in a packet of the other side's inputs, noting the earliest one that was mispredicted
+static void readInputs(const Uint8* bytes, int size)
+{
+    if(size < 34) return;
+    Uint32 ack, frame, lead, check, first;
+    Uint64 hash;
+    const Uint8* p = getWord(bytes + 5, &ack);
+    p = getWord(p, &frame);
+    p = getWord(p, &lead);
+    p = getWord(p, &check);
+    p = getWide(p, &hash);
+    p = getWord(p, &first);
+    int count = *p++;
+    if(size < (p - bytes) + 4 * count) return;
+
+    // Packets can arrive out of order, so only news is kept
+    if((int) ack > peer_ack) peer_ack = (int) ack;
+    if((int) frame > peer_frame)
+    {
+        peer_frame = (int) frame;
+        peer_lead = (int) lead;
+    }
+    if((int) check > peer_check)
+    {
+        peer_check = (int) check;
+        peer_hash = hash;
+    }
+
+    // Inputs are only taken in order, and only as far as the ring has room for them
+    for(int f = (int) first; f < (int) first + count; f++)
+    {
+        Uint32 input;
+        p = getWord(p, &input);
+        if(f != remote_frame + 1) continue;
+        if(f >= net_frame + NET_INPUT_RING - NET_SAVES) break;
+        remote_inputs[f % NET_INPUT_RING] = input;
+        remote_frame = f;
+        if(f < net_frame && predicted[f % NET_INPUT_RING] != input && (mispredicted < 0 || f < mispredicted))
+        {
+            mispredicted = f;
+        }
+    }
+}
+
+// Take in every packet the peer has sent
+static void receivePackets()
+{
+    Uint8 bytes[NET_PACKET_SIZE];
+    int size, type;
+    while((type = receivePacket(bytes, &size)) >= 0)
+    {
+        if(type == NET_INPUT) readInputs(bytes, size);
+        if(type == NET_BYE)   peer_left = true;
+    }
+}
+
+/* CONNECTING */
+
+// Connect to the other side of a game, and agree on the seed
+bool startNetplay(int guy, int port, const char* peer_host, int peer_port, int latency, int loss_percent, Uint64* seed)
+{
+    local_guy = guy;
+    net_latency = latency;
+    net_loss = loss_percent / 100.0;
+    seedRandom(&net_rng, timeSeed());
+
+    // Look up where the peer is
+    struct addrinfo hints, *found;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if(getaddrinfo(peer_host, NULL, &hints, &found)) return false;
+    peer_address = *(struct sockaddr_in*) found->ai_addr;
+    peer_address.sin_port = htons(peer_port);
+    freeaddrinfo(found);
+
+    // Listen on a socket that never blocks, and make room for the saved worlds
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    net_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    saves = (struct world*) malloc(NET_SAVES * sizeof(struct world));
+    if(net_socket < 0 || !saves || bind(net_socket, (struct sockaddr*) &local, sizeof(local)) < 0 ||
+       fcntl(net_socket, F_SETFL, O_NONBLOCK) < 0)
+    {
+        stopNetplay();
+        return false;
+    }
+
+    // Greet the peer until both sides know they've heard each other. Inputs are only sent once a side
+    // has been heard back, so they count as being heard back too
+    bool heard = false;
+    bool heard_back = false;
+    Uint32 start = SDL_GetTicks();
+    Uint32 last_hello = start - NET_HELLO_INTERVAL;
+    while(!heard_back)
+    {
+        Uint32 now = SDL_GetTicks();
+        if(now - start > NETPLAY_CONNECT_TIMEOUT)
+        {
+            stopNetplay();
+            return false;
+        }
+        if(now - last_hello >= NET_HELLO_INTERVAL)
+        {
+            sendHello(heard, *seed);
+            last_hello = now;
+        }
+        flushQueue();
+
+        Uint8 bytes[NET_PACKET_SIZE];
+        int size, type;
+        while((type = receivePacket(bytes, &size)) >= 0)
+        {
+            if(type == NET_HELLO && size >= 15 && bytes[5] != local_guy)
+            {
+                // The second guy plays with the first guy's seed
+                heard = true;
+                if(bytes[6]) heard_back = true;
+                if(local_guy == 1) getWide(bytes + 7, seed);
+            }
+            if(type == NET_INPUT && heard) heard_back = true;
+        }
+        SDL_Delay(1);
+    }
+
+    // Start the game with no input from either side, until this side's delayed input starts arriving
+    for(int f = 0; f < NET_INPUT_RING; f++) local_inputs[f] = remote_inputs[f] = predicted[f] = 0;
+    local_frame = NETPLAY_INPUT_DELAY - 1;
+    return true;
+}
+
+/* GETTERS */
+
+// Check whether a netplay game is being played
+bool isNetplay()
+{
+    return net_socket >= 0;
+}
+
+// Get which guy (0 or 1) is controlled on this side
+int getNetplayGuy()
+{
+    return local_guy;
+}
+
+// Check whether the netplay game is still going
+bool isNetplayConnected()
+{
+    return !peer_left && SDL_GetTicks() - last_heard < NETPLAY_TIMEOUT;
+}
+
+// Check whether frames are being simulated again after a misprediction
+bool isResimulating()
+{
+    return resimulating;
+}
+
+/* PER FRAME UPDATES */
+
+// Simulate one frame with this side's input and the other side's, predicting it to be the last one
+// known if it hasn't arrived yet, and saving the world from before the frame in case it's mispredicted
+static void simulateFrame(World w, int f, void (*update)(World, Uint32))
+{
+    Uint32 remote = 0;
+    if(f <= remote_frame)        remote = remote_inputs[f % NET_INPUT_RING];
+    else if(remote_frame >= 0)   remote = remote_inputs[remote_frame % NET_INPUT_RING];
+    predicted[f % NET_INPUT_RING] = remote;
+    copyWorld(&saves[f % NET_SAVES], w);
+    update(w, local_inputs[f % NET_INPUT_RING] | remote);
+}
+
+// Restore the world from before the earliest mispredicted frame, and simulate every frame since again
+static void rollBack(World w, void (*update)(World, Uint32))
+{
+    int depth = net_frame - mispredicted;
+    copyWorld(w, &saves[mispredicted % NET_SAVES]);
+    resimulating = true;
+    for(int f = mispredicted; f < net_frame; f++) simulateFrame(w, f, update);
+    resimulating = false;
+    mispredicted = -1;
+
+    rollbacks++;
+    resimulated += depth;
+    if(depth > deepest_rollback) deepest_rollback = depth;
+}
+
+// Hash the world after each check frame once both sides' inputs up to it are known, which is when
+// both sides must have the same world
+static void takeChecks(World w)
+{
+    while(next_check <= remote_frame && next_check < net_frame)
+    {
+        // The world after a frame is the one saved before the next frame (if it hasn't been overwritten)
+        int after = next_check + 1;
+        if(after == net_frame || after >= net_frame - NET_SAVES)
+        {
+            int c = (next_check / NETPLAY_CHECK_INTERVAL) % NET_CHECKS;
+            check_frames[c] = next_check;
+            check_hashes[c] = hashWorld(after == net_frame ? w : &saves[after % NET_SAVES]);
+            latest_check = next_check;
+        }
+        next_check += NETPLAY_CHECK_INTERVAL;
+    }
+
+    // Compare the other side's latest hash with this side's, once both have one for the same frame
+    int c = (peer_check / NETPLAY_CHECK_INTERVAL) % NET_CHECKS;
+    if(peer_check > compared_check && check_frames[c] == peer_check && latest_check >= peer_check)
+    {
+        if(check_hashes[c] == peer_hash) checks_matched++;
+        else if(!checks_differed++) fprintf(stderr, "Netplay: the worlds differ after frame %d\n", peer_check);
+        compared_check = peer_check;
+    }
+}
+
+// Advance the game by one tick with this side's input mask, rolling back first if needed
+bool playNetplayTick(World w, Uint32 input, void (*update)(World, Uint32))
+{
+    // Hear from the other side, and correct any mispredictions
+    flushQueue();
+    receivePackets();
+    if(mispredicted >= 0) rollBack(w, update);
+
+    // Wait for the other side if it's been predicted as far as it can be, and let it catch up if this side
+    // has been ahead of it (each side's idea of the other's frame is equally out of date, so half the
+    // difference between how far ahead they each think they are is how far ahead this side really is)
+    bool ticked = false;
+    int ahead = ((net_frame - peer_frame) - peer_lead) / 2;
+    if(net_frame - remote_frame > NETPLAY_MAX_PREDICTION)
+    {
+        stalls++;
+    }
+    else if(ahead >= 1 && net_frame - last_skip >= NET_SYNC_INTERVAL)
+    {
+        last_skip = net_frame;
+        skips++;
+    }
+    else
+    {
+        // This side's input is used a few frames from now
+        local_frame = net_frame + NETPLAY_INPUT_DELAY;
+        local_inputs[local_frame % NET_INPUT_RING] = input;
+        simulateFrame(w, net_frame, update);
+        net_frame++;
+        ticked = true;
+    }
+
+    // Check the world against the other side's, and send this side's inputs
+    takeChecks(w);
+    sendInputs();
+    return ticked;
+}
+
+/* DATA UNLOADING */
+
+// Say goodbye to the peer, close the connection, and report how the rollback went
+void stopNetplay()
+{
+    if(net_socket >= 0)
+    {
+        // The goodbye skips the artificial loss and latency, and is sent a few times in case one's lost anyway
+        Uint8 bytes[NET_PACKET_SIZE];
+        Uint8* p = putWord(bytes, NET_MAGIC);
+        *p++ = NET_BYE;
+        for(int i = 0; i < 3; i++) sendNow(bytes, p - bytes);
+        close(net_socket);
+        net_socket = -1;
+
+        if(net_frame)
+        {
+            printf("Netplay: %d frames, %lld rollbacks (%lld frames simulated again, at most %d at once), "
+                   "%lld ticks stalled, %lld skipped to keep in step\n",
+                   net_frame, rollbacks, resimulated, deepest_rollback, stalls, skips);
+            printf("World hashes checked with the other side: %d matched, %d differed\n", checks_matched, checks_differed);
+        }
+    }
+    free(saves);
+    saves = NULL;
+}
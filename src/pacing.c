@@ -0,0 +1,80 @@
+#include "../headers/constants.h"
+#include "../headers/pacing.h"
+
+// Number of buckets in the frame time histogram
+#define NUM_BUCKETS (MAX_FRAME_TIME_MS * 1000 / FRAME_TIME_BUCKET_US)
+
+Uint64 frame_ticks = 0;                     // Performance counter ticks per paced frame (0 if unpaced)
+Uint64 deadline = 0;                        // When the next frame should start
+Uint64 last_frame = 0;                      // When the last frame started
+
+long long frame_times[NUM_BUCKETS + 1];     // Histogram of frame times (the last bucket holds anything longer)
+long long timed_frames = 0;                 // Number of frames measured
+double total_frame_ms = 0;                  // Sum of all frame times
+double max_frame_ms = 0;                    // Longest frame time
+
+/* PACING */
+
+// Pace frames to fps frames per second
+void initPacing(int fps)
+{
+    frame_ticks = fps > 0 ? SDL_GetPerformanceFrequency() / fps : 0;
+    last_frame = SDL_GetPerformanceCounter();
+    deadline = last_frame + frame_ticks;
+}
+
+// Add the time between two frames to the statistics
+static void recordFrameTime(Uint64 ticks)
+{
+    double ms = ticks * 1000.0 / SDL_GetPerformanceFrequency();
+    int bucket = (int) (ms * 1000 / FRAME_TIME_BUCKET_US);
+    frame_times[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS]++;
+    timed_frames++;
+    total_frame_ms += ms;
+    if(ms > max_frame_ms) max_frame_ms = ms;
+}
+
+// Wait until it's time for the next frame to start, then record how long this frame took
+void waitForNextFrame()
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+    if(frame_ticks)
+    {
+        // Sleep while the deadline is comfortably far away
+        Uint64 spin_ticks = frequency * SPIN_MS / 1000;
+        if(deadline > now + spin_ticks)
+        {
+            SDL_Delay((Uint32) ((deadline - now - spin_ticks) * 1000 / frequency));
+        }
+
+        // Spin for the rest of the way
+        while((now = SDL_GetPerformanceCounter()) < deadline);
+
+        // Deadlines step by exactly one frame so there's no drift, unless a frame ran
+        // so long that the schedule has to start over
+        deadline += frame_ticks;
+        if(deadline < now) deadline = now + frame_ticks;
+    }
+
+    recordFrameTime(now - last_frame);
+    last_frame = now;
+}
+
+/* STATISTICS */
+
+// Print the mean, 99th percentile, and maximum time between frames
+void reportFrameTimes()
+{
+    if(!timed_frames) return;
+
+    // Find the bucket that the 99th percentile frame falls in
+    long long rank = (timed_frames * 99 + 99) / 100;
+    long long seen = 0;
+    int bucket = 0;
+    while(bucket < NUM_BUCKETS && (seen += frame_times[bucket]) < rank) bucket++;
+    double p99 = bucket < NUM_BUCKETS ? (bucket + 1) * FRAME_TIME_BUCKET_US / 1000.0 : max_frame_ms;
+
+    printf("Frame times over %lld frames: mean %.3f ms, p99 %.2f ms, max %.3f ms\n",
+           timed_frames, total_frame_ms / timed_frames, p99, max_frame_ms);
+}
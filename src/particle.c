@@ -0,0 +1,336 @@
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/particle.h"
+#include "../headers/simd.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/batch.h"
+#include "../headers/broadphase.h"
+#include "../headers/level.h"
+#include "../headers/world.h"
+
+// Struct for particle meta information
+typedef struct particle_metainfo
+{
+    int width;                  // width in pixels
+    int height;                 // height in pixels
+    int sheet_position;         // y-position of particle on the sprite sheet
+    int num_frames;             // number of animation frames while moving
+}* ParticleInfo;
+
+ParticleInfo* particle_info;    // Array of meta info structs, indexed by particle type
+double lowest_budget = 1;       // Lowest the particle budget of any world has been
+
+/* PARTICLE BUDGET */
+
+// Set the particle budget used by the simulation
+void setParticleBudget(World w, double budget)
+{
+    w->particle_budget = budget;
+    if(budget < lowest_budget) lowest_budget = budget;
+}
+
+// Get the particle budget used by the simulation
+double getParticleBudget(World w)
+{
+    return w->particle_budget;
+}
+
+// Get the lowest the particle budget has been
+double getLowestParticleBudget()
+{
+    return lowest_budget;
+}
+
+// Scale a burst of n particles to the budget
+int budgetBurst(World w, int n)
+{
+    if(w->particle_budget <= 0) return 0;
+    int scaled = (int) (n * w->particle_budget + 0.5);
+    return scaled < 1 ? 1 : scaled;
+}
+
+// Remove every particle from a world and stop it emitting any more
+void turnOffParticles(World w)
+{
+    w->particle_budget = 0;
+    for(int t = 0; t < NUM_PARTICLE_TYPES; t++)
+    {
+        w->particles[t].count = 0;
+        w->particles[t].live = 0;
+    }
+}
+
+// Work out the next particle budget: cut it sharply when a thread nears the deadline or the rings
+// are mostly full, and win it back slowly once there's room, so it doesn't oscillate
+double nextParticleBudget(double budget, double load, int live)
+{
+    double fill = live / (double) (NUM_PARTICLE_TYPES * PARTICLE_CAPACITY);
+    if(load > BUDGET_SHRINK_LOAD || fill > BUDGET_SHRINK_LOAD) budget *= 0.8;
+    else if(load < BUDGET_GROW_LOAD && fill < BUDGET_GROW_LOAD) budget += 0.01;
+    return fmax(MIN_PARTICLE_BUDGET, fmin(budget, 1));
+}
+
+// Render a meter showing the particle budget in the top right corner, turning from green to red as it shrinks
+void renderParticleBudget(double budget)
+{
+    SDL_Rect meter = {SCREEN_WIDTH - 110, 10, 100, 8};
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderDrawRect(renderer, &meter);
+    meter.w = (int) (meter.w * budget);
+    SDL_SetRenderDrawColor(renderer, (Uint8) (0xFF * (1 - budget)), (Uint8) (0xFF * budget), 0x00, 0xFF);
+    SDL_RenderFillRect(renderer, &meter);
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+}
+
+/* PARTICLE CONSTRUCTOR */
+
+// Emit a particle of the given type
+void emitParticle(World w, int id, double x, double y, double xv, double yv, bool dir, int angle, int life)
+{
+    // A world with particles turned off never has any
+    if(w->particle_budget <= 0) return;
+
+    // If the ring is full, the oldest particle is replaced
+    struct particle_ring* ring = &w->particles[id - FIRST_PARTICLE];
+    int p = ring->head;
+    if(ring->count == PARTICLE_CAPACITY)
+    {
+        if(ring->alive[p]) ring->live--;
+        ring->count--;
+    }
+
+    // Set particle fields
+    ring->alive[p] = true;
+    ring->x_pos[p] = x;         ring->y_pos[p] = y;
+    ring->x_prev[p] = x;        ring->y_prev[p] = y;
+    ring->x_vel[p] = xv;        ring->y_vel[p] = yv;
+    ring->direction[p] = dir;   ring->angle[p] = angle;
+    ring->lifetime[p] = life;   ring->frame[p] = 0;
+
+    // Advance the head of the ring
+    ring->head = (p + 1) & (PARTICLE_CAPACITY - 1);
+    ring->count++;
+    ring->live++;
+    if(ring->live > ring->high_water) ring->high_water = ring->live;
+}
+
+/* GETTERS */
+
+// Get the most particles of a type that have ever been live at once
+int getParticleHighWater(World w, int id)
+{
+    return w->particles[id - FIRST_PARTICLE].high_water;
+}
+
+/* PER FRAME UPDATES */
+
+// Update velocity and orientation of the particles in slots [start, end) of a ring
+// (the deterministic parts run as SIMD kernels over the whole batch)
+static void accelerateParticles(World w, int id, struct particle_ring* ring, int start, int end)
+{
+    // The physics are different for different particles
+    int n = end - start;
+    switch(id)
+    {
+        case ICESHOCK_P1:
+            // Ice particles are affected by gravity and air resistance
+            addConstant(&ring->y_vel[start], 0.3, n);
+            applyDrag(&ring->x_vel[start], 0.03, n);
+
+            // Ice particles face in the direction of xy-velocity
+            for(int p = start; p < end; p++)
+            {
+                ring->direction[p] = (ring->x_vel[p] >= 0);
+                ring->angle[p] = (int) (57.296 * atan(ring->y_vel[p] / ring->x_vel[p]));
+            }
+            break;
+
+        case ROCKFALL_P1:
+        case ROCKFALL_P2:
+            // Rockfall particles rotate and fall
+            for(int p = start; p < end; p++) ring->direction[p] = (ring->x_vel[p] >= 0);
+            addConstantInt(&ring->angle[start], 5, n);
+            addConstant(&ring->y_vel[start], 0.3, n);
+            break;
+
+        case DARKEDGE_P1:
+            // Darkedge particles wobble around randomly
+            for(int p = start; p < end; p++)
+            {
+                if(!ring->alive[p] || get_rand(&w->rng, RNG_COSMETIC) > 0.05) continue;
+                ring->x_vel[p] = (get_rand(&w->rng, RNG_COSMETIC) - 0.5) / 2;
+                ring->y_vel[p] = (get_rand(&w->rng, RNG_COSMETIC) - 0.5) / 2;
+            }
+            break;
+
+        case FIREBALL_P1:
+            // Fireball particles drift at a constant velocity
+            break;
+
+        case ARCSURGE_P1:
+            // Arcsurge particles randomly change direction
+            for(int p = start; p < end; p++)
+            {
+                if(!ring->alive[p] || get_rand(&w->rng, RNG_COSMETIC) > 0.2) continue;
+                double tmp = fabs(ring->x_vel[p]) * convert(get_rand(&w->rng, RNG_COSMETIC) - 0.5 > 0);
+                ring->x_vel[p] = ring->y_vel[p];
+                ring->y_vel[p] = tmp;
+                ring->x_vel[p] += (get_rand(&w->rng, RNG_COSMETIC) - 0.5)*3;
+            }
+
+            // Arcsurge particles slow down heavily but do not fall
+            applyDrag(&ring->x_vel[start], 0.1, n);
+            applyDrag(&ring->y_vel[start], 0.1, n);
+            break;
+    }
+}
+
+// Integrate, collide, age, and animate the particles in slots [start, end) of a ring
+static void updateParticleRange(World w, int id, struct particle_ring* ring, int start, int end, int* platforms, int* walls)
+{
+    // Remember positions for interpolation, then update positions, then velocities and orientations
+    for(int p = start; p < end; p++) ring->x_prev[p] = ring->x_pos[p];
+    for(int p = start; p < end; p++) ring->y_prev[p] = ring->y_pos[p];
+    addArrays(&ring->x_pos[start], &ring->x_vel[start], end - start);
+    addArrays(&ring->y_pos[start], &ring->y_vel[start], end - start);
+    accelerateParticles(w, id, ring, start, end);
+
+    // Kill particles that touch the ground or a wall, leave the screen, or run out of lifetime
+    ParticleInfo meta = particle_info[id - FIRST_PARTICLE];
+    int num_walls = walls[0];
+    for(int p = start; p < end; p++)
+    {
+        if(!ring->alive[p]) continue;
+        double x = ring->x_pos[p];
+        double y = ring->y_pos[p];
+        double middle = (int) (x + meta->width / 2.0);
+        bool dead = (y + meta->height >= platforms[1]) && (middle > platforms[2] && middle < platforms[3]);
+        for(int k = 1; !dead && k < num_walls*3 + 1; k += 3)
+        {
+            dead = walls[k] < x + meta->width && walls[k] > x && walls[k+1] < y + meta->height && walls[k+2] > y;
+        }
+        if(x < -500 || x > SCREEN_WIDTH+500 || y <= -500 || y >= SCREEN_HEIGHT+100) dead = true;
+        if(ring->lifetime[p] && --ring->lifetime[p] == 1) dead = true;
+        if(dead)
+        {
+            ring->alive[p] = false;
+            ring->live--;
+        }
+    }
+
+    // Advance through the moving animation, wrapping around at its last frame
+    for(int p = start; p < end; p++)
+    {
+        ring->frame[p] += ANIMATION_SPEED * 0.1;
+        if(ring->frame[p] >= meta->num_frames) ring->frame[p] = 0;
+    }
+}
+
+// Move all particles, and kill those that hit terrain, leave the screen, or run out of lifetime
+void updateParticles(World w, int* platforms, int* walls)
+{
+    for(int t = 0; t < NUM_PARTICLE_TYPES; t++)
+    {
+        // The occupied part of a ring is at most two contiguous runs of slots
+        struct particle_ring* ring = &w->particles[t];
+        int tail = (ring->head - ring->count) & (PARTICLE_CAPACITY - 1);
+        if(tail + ring->count <= PARTICLE_CAPACITY)
+        {
+            updateParticleRange(w, t + FIRST_PARTICLE, ring, tail, tail + ring->count, platforms, walls);
+        }
+        else
+        {
+            updateParticleRange(w, t + FIRST_PARTICLE, ring, tail, PARTICLE_CAPACITY, platforms, walls);
+            updateParticleRange(w, t + FIRST_PARTICLE, ring, 0, ring->head, platforms, walls);
+        }
+
+        // Retire dead particles from the tail of the ring
+        while(ring->count && !ring->alive[tail])
+        {
+            tail = (tail + 1) & (PARTICLE_CAPACITY - 1);
+            ring->count--;
+        }
+    }
+}
+
+// Capture everything needed to draw the live particles
+void captureParticles(World w, struct particle_view* view)
+{
+    for(int t = 0; t < NUM_PARTICLE_TYPES; t++)
+    {
+        // Live particles are packed together, oldest first
+        struct particle_ring* ring = &w->particles[t];
+        int n = 0;
+        for(int k = 0; k < ring->count; k++)
+        {
+            int p = (ring->head - ring->count + k) & (PARTICLE_CAPACITY - 1);
+            if(!ring->alive[p]) continue;
+            view->x_prev[t][n] = ring->x_prev[p];       view->y_prev[t][n] = ring->y_prev[p];
+            view->x_pos[t][n] = ring->x_pos[p];         view->y_pos[t][n] = ring->y_pos[p];
+            view->direction[t][n] = ring->direction[p]; view->angle[t][n] = ring->angle[p];
+            view->frame[t][n] = ring->frame[p];
+            n++;
+        }
+        view->count[t] = n;
+    }
+}
+
+// Render captured particles to the screen, between their previous and current positions
+void renderParticles(const struct particle_view* view, double alpha)
+{
+    for(int t = 0; t < NUM_PARTICLE_TYPES; t++)
+    {
+        ParticleInfo meta = particle_info[t];
+        for(int p = 0; p < view->count[t]; p++)
+        {
+            // Grab the particle at its current frame from the spritesheet, facing the proper direction
+            SDL_RendererFlip flipType = SDL_FLIP_NONE;
+            if(view->direction[t][p] == LEFT) flipType = SDL_FLIP_HORIZONTAL;
+            SDL_Rect clip = {meta->width * (int) view->frame[t][p], meta->sheet_position, meta->width, meta->height};
+
+            // Draw the particle between its previous and current x and y position
+            int x = (int) lerp(view->x_prev[t][p], view->x_pos[t][p], alpha);
+            int y = (int) lerp(view->y_prev[t][p], view->y_pos[t][p], alpha);
+            SDL_Rect renderQuad = {x, y, meta->width, meta->height};
+            batchCopy(&clip, &renderQuad, view->angle[t][p], flipType);
+        }
+    }
+}
+
+/* DATA ALLOCATION / INITIALIZATION */
+
+// Assign meta info fields for a particle
+static ParticleInfo initParticle(int width, int height, int sheet_pos, int num_frames)
+{
+    ParticleInfo this_particle = (ParticleInfo) malloc(sizeof(struct particle_metainfo));
+    this_particle->width = width;
+    this_particle->height = height;
+    this_particle->sheet_position = sheet_pos;
+    this_particle->num_frames = num_frames;
+    return this_particle;
+}
+
+// Fill the meta info list with meta info for each particle in the game
+void loadParticles()
+{
+    particle_info = (ParticleInfo*) malloc(sizeof(ParticleInfo) * NUM_PARTICLE_TYPES);
+    particle_info[FIREBALL_P1 - FIRST_PARTICLE] = initParticle(5, 5, 315, 2);
+    particle_info[ICESHOCK_P1 - FIRST_PARTICLE] = initParticle(5, 5, 80, 2);
+    particle_info[ROCKFALL_P1 - FIRST_PARTICLE] = initParticle(25, 25, 185, 1);
+    particle_info[ROCKFALL_P2 - FIRST_PARTICLE] = initParticle(5, 5, 210, 2);
+    particle_info[DARKEDGE_P1 - FIRST_PARTICLE] = initParticle(5, 5, 245, 2);
+    particle_info[ARCSURGE_P1 - FIRST_PARTICLE] = initParticle(5, 5, 310, 2);
+}
+
+/* DATA UNLOADING */
+
+// Free particle meta info
+void freeParticles()
+{
+    for(int t = 0; t < NUM_PARTICLE_TYPES; t++)
+    {
+        free(particle_info[t]);
+    }
+    free(particle_info);
+}
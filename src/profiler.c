@@ -0,0 +1,174 @@
+#include "../headers/constants.h"
+#include "../headers/profiler.h"
+#include "../headers/trace.h"
+
+// Position and scale of the overlay bar
+#define BAR_X 10
+#define BAR_Y (SCREEN_HEIGHT - 20)
+#define BAR_HEIGHT 10
+#define PIXELS_PER_MS 30
+
+// Names of each phase, used as CSV column headers and trace event names
+static const char* phase_names[NUM_PHASES] =
+{
+    "events", "input", "ai", "particles", "move", "terrain",
+    "collisions", "launch", "timers", "unload", "animation",
+    "capture", "render_level", "render_particles", "render_sprites", "render_interface",
+    "present", "sleep", "wait"
+};
+
+// Which lane each phase runs in
+static const int phase_lane[NUM_PHASES] =
+{
+    LANE_MAIN, LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION,
+    LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION, LANE_SIMULATION,
+    LANE_MAIN, LANE_MAIN, LANE_MAIN, LANE_MAIN,
+    LANE_MAIN, LANE_MAIN, LANE_MAIN
+};
+
+// Color of each phase in the overlay bar
+static const Uint8 phase_colors[NUM_PHASES][3] =
+{
+    {0x80, 0x80, 0x80}, {0xC0, 0xC0, 0xC0}, {0xFF, 0xFF, 0x00}, {0xFF, 0x80, 0x00}, {0x00, 0xFF, 0x00},
+    {0x00, 0x80, 0x00}, {0xFF, 0x00, 0x00}, {0xFF, 0x00, 0xFF}, {0x80, 0x00, 0x80}, {0x00, 0xFF, 0xFF},
+    {0x00, 0x80, 0x80}, {0x80, 0x40, 0x00}, {0x00, 0x00, 0xFF}, {0x40, 0x40, 0xFF}, {0x80, 0x80, 0xFF},
+    {0xC0, 0xC0, 0xFF}, {0xFF, 0xFF, 0xFF}, {0x20, 0x20, 0x20}, {0x40, 0x00, 0x00}
+};
+
+bool profiling = false;                         // Whether phases are being timed at all
+bool show_overlay = false;                      // Whether the overlay bar is drawn
+FILE* csv = NULL;                               // File per-frame timings are written to
+
+Uint64 last_mark[NUM_LANES];                    // Performance counter at the last phase mark in each lane
+Uint64 current[NUM_PHASES];                     // Ticks spent in each phase so far this frame
+double history[PROFILE_HISTORY][NUM_PHASES];    // Milliseconds spent in each phase in recent frames
+double history_sum[NUM_PHASES];                 // Sum of each phase over the history
+long long profiled_frames = 0;                  // Number of frames timed so far
+
+/* SETUP */
+
+// Start profiling, with the overlay shown or not, and per-frame timings written to a CSV file
+bool initProfiler(bool overlay, const char* csv_path)
+{
+    show_overlay = overlay;
+    if(csv_path)
+    {
+        csv = fopen(csv_path, "w");
+        if(!csv) return false;
+
+        // Header row: one column per phase in microseconds, then the whole frame
+        fprintf(csv, "frame");
+        for(int p = 0; p < NUM_PHASES; p++) fprintf(csv, ",%s", phase_names[p]);
+        fprintf(csv, ",total\n");
+    }
+    profiling = show_overlay || csv || isTracing();
+    return true;
+}
+
+// Close the CSV file
+void closeProfiler()
+{
+    if(csv) fclose(csv);
+    csv = NULL;
+    profiling = false;
+}
+
+/* TIMING */
+
+// Start timing a new frame
+void beginFrame()
+{
+    if(!profiling) return;
+    for(int p = 0; p < NUM_PHASES; p++) current[p] = 0;
+    Uint64 now = SDL_GetPerformanceCounter();
+    for(int l = 0; l < NUM_LANES; l++) last_mark[l] = now;
+    traceEventAt("frame", 'B', now);
+}
+
+// Start timing a lane's phases from now
+void beginLane(int lane)
+{
+    if(!profiling) return;
+    last_mark[lane] = SDL_GetPerformanceCounter();
+}
+
+// Mark the end of a phase, charging it with the time since the last mark in its lane
+void markPhase(int phase)
+{
+    if(!profiling) return;
+    Uint64* mark = &last_mark[phase_lane[phase]];
+    Uint64 now = SDL_GetPerformanceCounter();
+    current[phase] += now - *mark;
+
+    // Each phase also shows up as its own span on the trace timeline
+    traceEventAt(phase_names[phase], 'B', *mark);
+    traceEventAt(phase_names[phase], 'E', now);
+    *mark = now;
+}
+
+// Finish timing a frame, adding it to the history and the CSV file
+void endFrame()
+{
+    if(!profiling) return;
+    traceEventAt("frame", 'E', last_mark[LANE_MAIN]);
+
+    // Replace the oldest frame in the history, keeping the sums up to date
+    double ms_per_tick = 1000.0 / SDL_GetPerformanceFrequency();
+    double* slot = history[profiled_frames % PROFILE_HISTORY];
+    double total = 0;
+    for(int p = 0; p < NUM_PHASES; p++)
+    {
+        double ms = current[p] * ms_per_tick;
+        history_sum[p] += ms - slot[p];
+        slot[p] = ms;
+        total += ms;
+    }
+
+    // Write the frame's timings in microseconds
+    if(csv)
+    {
+        fprintf(csv, "%lld", profiled_frames);
+        for(int p = 0; p < NUM_PHASES; p++) fprintf(csv, ",%.1f", slot[p] * 1000);
+        fprintf(csv, ",%.1f\n", total * 1000);
+    }
+    profiled_frames++;
+}
+
+// Get the average time in milliseconds spent in a phase over recent frames
+double getPhaseAverage(int phase)
+{
+    long long frames = profiled_frames < PROFILE_HISTORY ? profiled_frames : PROFILE_HISTORY;
+    if(!frames) return 0;
+    return history_sum[phase] / frames;
+}
+
+/* RENDERING */
+
+// Draw bars breaking down recent frames by phase, with a tick at the frame budget
+void renderProfile()
+{
+    if(!show_overlay) return;
+
+    // One bar per lane (the main thread's at the bottom), with one segment per phase, in order,
+    // sized by its average time
+    for(int l = 0; l < NUM_LANES; l++)
+    {
+        int y = BAR_Y - l * (BAR_HEIGHT + 2);
+        double x = BAR_X;
+        for(int p = 0; p < NUM_PHASES; p++)
+        {
+            if(phase_lane[p] != l) continue;
+            double w = getPhaseAverage(p) * PIXELS_PER_MS;
+            SDL_Rect segment = {(int) x, y, (int) (x + w) - (int) x, BAR_HEIGHT};
+            SDL_SetRenderDrawColor(renderer, phase_colors[p][0], phase_colors[p][1], phase_colors[p][2], 0xFF);
+            SDL_RenderFillRect(renderer, &segment);
+            x += w;
+        }
+    }
+
+    // Mark where a frame at MAX_FPS has to end
+    int budget = BAR_X + (int) (1000.0 / MAX_FPS * PIXELS_PER_MS);
+    int top = BAR_Y - (NUM_LANES - 1) * (BAR_HEIGHT + 2);
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderDrawLine(renderer, budget, top - 4, budget, BAR_Y + BAR_HEIGHT + 4);
+}
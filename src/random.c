@@ -0,0 +1,58 @@
+#include "../headers/constants.h"
+#include "../headers/random.h"
+#include "../headers/replay.h"
+
+/* SEEDING */
+
+// Get the next output of a splitmix64 generator, used to expand a seed into stream states
+static Uint64 splitMix(Uint64* x)
+{
+    Uint64 z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Seed every stream from a single seed
+void seedRandom(struct rng_state* rng, Uint64 seed)
+{
+    // Each stream gets its own state, expanded from the seed and the stream's number
+    rng->seed = seed;
+    for(int r = 0; r < NUM_RNG_STREAMS; r++)
+    {
+        Uint64 x = seed ^ ((Uint64) r * 0xD1B54A32D192ED03ULL);
+        for(int i = 0; i < 4; i++) rng->streams[r].s[i] = splitMix(&x);
+    }
+}
+
+// Get the seed the streams were last seeded with
+Uint64 getSeed(const struct rng_state* rng)
+{
+    return rng->seed;
+}
+
+// Pick a seed which differs from run to run
+Uint64 timeSeed()
+{
+    Uint64 x = SDL_GetPerformanceCounter();
+    return splitMix(&x);
+}
+
+// Mix the state of every stream that affects gameplay into a hash (leaving out the cosmetic stream,
+// which the particle budget makes differ from run to run)
+Uint64 hashRandom(const struct rng_state* rng, Uint64 hash)
+{
+    for(int r = 0; r < NUM_RNG_STREAMS; r++)
+    {
+        if(r != RNG_COSMETIC) hash = hashBytes(hash, rng->streams[r].s, sizeof(rng->streams[r].s));
+    }
+    return hash;
+}
+
+/* BULK GENERATION */
+
+// Fill out[0, n) with random numbers in [0, 1) from a stream
+void fillRand(struct rng_state* rng, int stream, double* out, int n)
+{
+    for(int i = 0; i < n; i++) out[i] = get_rand(rng, stream);
+}
@@ -0,0 +1,228 @@
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/cpu.h"
+#include "../headers/replay.h"
+
+FILE* replay_file = NULL;           // File being recorded to or played back from
+bool recording = false;             // Whether a replay is being recorded
+bool replaying = false;             // Whether a replay is being played back
+Uint32 replay_input = 0;            // Input mask of the ticks being recorded or played back
+Uint32 pending_ticks = 0;           // Ticks with that input not yet written, or not yet played back
+long long replay_ticks = 0;         // Number of ticks recorded or played back so far
+long long end_ticks = -1;           // Number of ticks stored at the end of the replay
+Uint64 end_hash = 0;                // World hash stored at the end of the replay
+
+/* ENCODING */
+
+// Write a number in as few bytes as it needs, seven bits at a time, lowest first
+static void writeNumber(Uint32 n)
+{
+    while(n >= 0x80)
+    {
+        fputc((int) (n & 0x7F) | 0x80, replay_file);
+        n >>= 7;
+    }
+    fputc((int) n, replay_file);
+}
+
+// Read a number written by writeNumber
+static Uint32 readNumber()
+{
+    Uint32 n = 0;
+    for(int shift = 0; shift < 35; shift += 7)
+    {
+        int c = fgetc(replay_file);
+        if(c == EOF) break;
+        n |= (Uint32) (c & 0x7F) << shift;
+        if(!(c & 0x80)) break;
+    }
+    return n;
+}
+
+// Write a 64-bit value, lowest byte first
+static void writeWide(Uint64 n)
+{
+    for(int i = 0; i < 8; i++) fputc((int) ((n >> (8 * i)) & 0xFF), replay_file);
+}
+
+// Read a 64-bit value written by writeWide, returning false at the end of the file
+static bool readWide(Uint64* n)
+{
+    *n = 0;
+    for(int i = 0; i < 8; i++)
+    {
+        int c = fgetc(replay_file);
+        if(c == EOF) return false;
+        *n |= (Uint64) c << (8 * i);
+    }
+    return true;
+}
+
+/* RECORDING */
+
+// Start recording a replay to path of a game seeded with seed
+bool startRecording(const char* path, Uint64 seed, bool debug, int cpu)
+{
+    replay_file = fopen(path, "wb");
+    if(!replay_file) return false;
+    writeWide(REPLAY_MAGIC | (Uint64) REPLAY_VERSION << 32);
+    writeWide(seed);
+    fputc(debug, replay_file);
+    fputc(cpu, replay_file);
+    replay_input = 0;
+    pending_ticks = 0;
+    replay_ticks = 0;
+    recording = true;
+    return true;
+}
+
+// Check whether a replay is being recorded
+bool isRecording()
+{
+    return recording;
+}
+
+// Write out the run of ticks recorded since the input last changed
+static void flushTicks()
+{
+    if(!pending_ticks) return;
+    fputc(REPLAY_TICK, replay_file);
+    writeNumber(pending_ticks);
+    pending_ticks = 0;
+}
+
+// Record the input mask of a simulation tick
+void recordTick(Uint32 input)
+{
+    if(!recording) return;
+    if(input != replay_input)
+    {
+        flushTicks();
+        fputc(REPLAY_INPUT, replay_file);
+        writeNumber(input);
+        replay_input = input;
+    }
+    pending_ticks++;
+    replay_ticks++;
+}
+
+// Record a change made between ticks
+void recordEvent(int type, int value)
+{
+    if(!recording) return;
+    flushTicks();
+    fputc(type, replay_file);
+    writeNumber((Uint32) value);
+}
+
+// Finish recording with the hash of the final world
+bool finishRecording(Uint64 hash)
+{
+    if(!recording) return true;
+    flushTicks();
+    fputc(REPLAY_END, replay_file);
+    writeWide((Uint64) replay_ticks);
+    writeWide(hash);
+    recording = false;
+    bool written = !ferror(replay_file);
+    return fclose(replay_file) == 0 && written;
+}
+
+/* PLAYBACK */
+
+// Open a replay from path, getting the seed, mode, and cpu player it was played with
+bool openReplay(const char* path, Uint64* seed, bool* debug, int* cpu)
+{
+    replay_file = fopen(path, "rb");
+    if(!replay_file) return false;
+
+    // Check the file is a replay this version can play (version 1 replays were played against the classic cpu)
+    Uint64 magic;
+    int mode = EOF;
+    int player = CPU_CLASSIC;
+    bool readable = readWide(&magic) && readWide(seed) && (mode = fgetc(replay_file)) != EOF;
+    int version = (int) (magic >> 32);
+    if(readable && version == REPLAY_VERSION) readable = (player = fgetc(replay_file)) != EOF;
+    if(!readable || (Uint32) magic != REPLAY_MAGIC || (version != 1 && version != REPLAY_VERSION))
+    {
+        fclose(replay_file);
+        replay_file = NULL;
+        return false;
+    }
+    *debug = mode;
+    *cpu = player;
+    replay_input = 0;
+    pending_ticks = 0;
+    replay_ticks = 0;
+    end_ticks = -1;
+    replaying = true;
+    return true;
+}
+
+// Check whether a replay is being played back
+bool isReplaying()
+{
+    return replaying;
+}
+
+// Read the replay up to its next tick
+int readReplay(Uint32* input, int* value)
+{
+    while(replaying)
+    {
+        // Play back the current run of ticks first
+        if(pending_ticks)
+        {
+            pending_ticks--;
+            replay_ticks++;
+            *input = replay_input;
+            return REPLAY_TICK;
+        }
+
+        int type = fgetc(replay_file);
+        switch(type)
+        {
+            case REPLAY_TICK:
+                pending_ticks = readNumber();
+                break;
+
+            case REPLAY_INPUT:
+                replay_input = readNumber();
+                break;
+
+            case REPLAY_MODE:
+            case REPLAY_LEVEL:
+            case REPLAY_SCORE:
+                *value = (int) readNumber();
+                return type;
+
+            default:
+            {
+                // The end of the replay (a truncated replay just stops, with no hash to check)
+                Uint64 ticks, hash;
+                if(type == REPLAY_END && readWide(&ticks) && readWide(&hash))
+                {
+                    end_ticks = (long long) ticks;
+                    end_hash = hash;
+                }
+                replaying = false;
+            }
+        }
+    }
+    return REPLAY_END;
+}
+
+// Get the number of ticks and world hash stored at the end of the replay
+void getReplayEnd(long long* ticks, Uint64* hash)
+{
+    *ticks = end_ticks;
+    *hash = end_hash;
+}
+
+// Close the replay
+void closeReplay()
+{
+    if(replay_file && !recording) fclose(replay_file);
+    replay_file = NULL;
+    replaying = false;
+}
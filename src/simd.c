@@ -0,0 +1,315 @@
+#include "../headers/constants.h"
+#include "../headers/simd.h"
+
+// x86 vector instructions are only available on x86 builds, other builds always use scalar code. Each kernel is
+// compiled for its own instruction set, so they build even where the compiler may not assume it (e.g. 32-bit x86)
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+// Verification compares against scalar results in chunks of this many elements
+#define VERIFY_CHUNK 256
+
+// Largest absolute difference from the scalar result that verification accepts
+#define VERIFY_TOLERANCE 1e-9
+
+// Struct for the set of kernels for one instruction set
+struct kernels
+{
+    const char* name;
+    void (*add_arrays)(double*, const double*, int);
+    void (*add_constant)(double*, double, int);
+    void (*add_constant_int)(int*, int, int);
+    void (*apply_drag)(double*, double, int);
+};
+
+/* SCALAR KERNELS */
+
+// a[i] += b[i], one element at a time
+static void addArraysScalar(double* a, const double* b, int n)
+{
+    for(int i = 0; i < n; i++) a[i] += b[i];
+}
+
+// a[i] += k, one element at a time
+static void addConstantScalar(double* a, double k, int n)
+{
+    for(int i = 0; i < n; i++) a[i] += k;
+}
+
+// a[i] += k on integers, one element at a time
+static void addConstantIntScalar(int* a, int k, int n)
+{
+    for(int i = 0; i < n; i++) a[i] += k;
+}
+
+// Slow a[i] down by d, one element at a time
+static void applyDragScalar(double* a, double d, int n)
+{
+    for(int i = 0; i < n; i++) a[i] += convert(a[i] < 0) * d;
+}
+
+static const struct kernels scalar_kernels =
+{ "scalar", addArraysScalar, addConstantScalar, addConstantIntScalar, applyDragScalar };
+
+#ifdef HAVE_X86_SIMD
+
+/* SSE2 KERNELS (2 doubles or 4 ints per instruction) */
+
+// a[i] += b[i], two elements at a time
+SSE2_TARGET static void addArraysSSE2(double* a, const double* b, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    addArraysScalar(a + i, b + i, n - i);
+}
+
+// a[i] += k, two elements at a time
+SSE2_TARGET static void addConstantSSE2(double* a, double k, int n)
+{
+    __m128d vk = _mm_set1_pd(k);
+    int i = 0;
+    for(; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), vk));
+    addConstantScalar(a + i, k, n - i);
+}
+
+// a[i] += k on integers, four elements at a time
+SSE2_TARGET static void addConstantIntSSE2(int* a, int k, int n)
+{
+    __m128i vk = _mm_set1_epi32(k);
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i* p = (__m128i*) (a + i);
+        _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), vk));
+    }
+    addConstantIntScalar(a + i, k, n - i);
+}
+
+// Slow a[i] down by d, two elements at a time
+SSE2_TARGET static void applyDragSSE2(double* a, double d, int n)
+{
+    // Pick +d where the value is negative and -d elsewhere, with a comparison mask
+    __m128d pos = _mm_set1_pd(d);
+    __m128d neg = _mm_set1_pd(-d);
+    __m128d zero = _mm_setzero_pd();
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        __m128d v = _mm_loadu_pd(a + i);
+        __m128d mask = _mm_cmplt_pd(v, zero);
+        __m128d delta = _mm_or_pd(_mm_and_pd(mask, pos), _mm_andnot_pd(mask, neg));
+        _mm_storeu_pd(a + i, _mm_add_pd(v, delta));
+    }
+    applyDragScalar(a + i, d, n - i);
+}
+
+static const struct kernels sse2_kernels =
+{ "sse2", addArraysSSE2, addConstantSSE2, addConstantIntSSE2, applyDragSSE2 };
+
+/* AVX2 KERNELS (4 doubles or 8 ints per instruction) */
+
+// a[i] += b[i], four elements at a time
+AVX2_TARGET static void addArraysAVX2(double* a, const double* b, int n)
+{
+    int i = 0;
+    for(; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    addArraysScalar(a + i, b + i, n - i);
+}
+
+// a[i] += k, four elements at a time
+AVX2_TARGET static void addConstantAVX2(double* a, double k, int n)
+{
+    __m256d vk = _mm256_set1_pd(k);
+    int i = 0;
+    for(; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), vk));
+    addConstantScalar(a + i, k, n - i);
+}
+
+// a[i] += k on integers, eight elements at a time
+AVX2_TARGET static void addConstantIntAVX2(int* a, int k, int n)
+{
+    __m256i vk = _mm256_set1_epi32(k);
+    int i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i* p = (__m256i*) (a + i);
+        _mm256_storeu_si256(p, _mm256_add_epi32(_mm256_loadu_si256(p), vk));
+    }
+    addConstantIntScalar(a + i, k, n - i);
+}
+
+// Slow a[i] down by d, four elements at a time
+AVX2_TARGET static void applyDragAVX2(double* a, double d, int n)
+{
+    // Pick +d where the value is negative and -d elsewhere, with a comparison mask
+    __m256d pos = _mm256_set1_pd(d);
+    __m256d neg = _mm256_set1_pd(-d);
+    __m256d zero = _mm256_setzero_pd();
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m256d v = _mm256_loadu_pd(a + i);
+        __m256d mask = _mm256_cmp_pd(v, zero, _CMP_LT_OQ);
+        _mm256_storeu_pd(a + i, _mm256_add_pd(v, _mm256_blendv_pd(neg, pos, mask)));
+    }
+    applyDragScalar(a + i, d, n - i);
+}
+
+static const struct kernels avx2_kernels =
+{ "avx2", addArraysAVX2, addConstantAVX2, addConstantIntAVX2, applyDragAVX2 };
+
+#endif
+
+const struct kernels* active_kernels = &scalar_kernels; // Kernels in use
+bool verify_simd = false;                               // Compare every kernel against the scalar version
+long long simd_mismatches = 0;                          // Results that differed from the scalar version
+
+/* KERNEL SELECTION */
+
+// Choose the widest kernels that are allowed and supported by the CPU
+void initSIMD(int level, bool verify)
+{
+    active_kernels = &scalar_kernels;
+#ifdef HAVE_X86_SIMD
+    if(level >= SIMD_SSE2 && SDL_HasSSE2()) active_kernels = &sse2_kernels;
+    if(level >= SIMD_AVX2 && SDL_HasAVX2()) active_kernels = &avx2_kernels;
+#endif
+    verify_simd = verify;
+}
+
+// Look up an instruction set by name, returning -1 if there's no such set
+int simdByName(const char* name)
+{
+    if(!strcmp(name, "scalar")) return SIMD_SCALAR;
+    if(!strcmp(name, "sse2"))   return SIMD_SSE2;
+    if(!strcmp(name, "avx2"))   return SIMD_AVX2;
+    return -1;
+}
+
+// Get the name of the instruction set in use
+const char* getSIMDName()
+{
+    return active_kernels->name;
+}
+
+// Get whether verification mode is on
+bool getSIMDVerify()
+{
+    return verify_simd;
+}
+
+// Get how many results have differed from the scalar kernels in verification mode
+long long getSIMDMismatches()
+{
+    return simd_mismatches;
+}
+
+/* VERIFICATION */
+
+// Count the results of a vector kernel which differ from the scalar results
+static void compareDoubles(const double* vector, const double* scalar, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        if(fabs(vector[i] - scalar[i]) > VERIFY_TOLERANCE) simd_mismatches++;
+    }
+}
+
+// Count the results of a vector kernel which differ from the scalar results, on integers
+static void compareInts(const int* vector, const int* scalar, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        if(vector[i] != scalar[i]) simd_mismatches++;
+    }
+}
+
+/* KERNELS */
+
+// a[i] += b[i] for i in [0, n)
+void addArrays(double* a, const double* b, int n)
+{
+    if(!verify_simd)
+    {
+        active_kernels->add_arrays(a, b, n);
+        return;
+    }
+
+    // Run the scalar kernel on a copy of each chunk, and compare it with the vector result
+    for(int c = 0; c < n; c += VERIFY_CHUNK)
+    {
+        double expected[VERIFY_CHUNK];
+        int m = fmin(n - c, VERIFY_CHUNK);
+        memcpy(expected, a + c, sizeof(double) * m);
+        addArraysScalar(expected, b + c, m);
+        active_kernels->add_arrays(a + c, b + c, m);
+        compareDoubles(a + c, expected, m);
+    }
+}
+
+// a[i] += k for i in [0, n)
+void addConstant(double* a, double k, int n)
+{
+    if(!verify_simd)
+    {
+        active_kernels->add_constant(a, k, n);
+        return;
+    }
+
+    // Run the scalar kernel on a copy of each chunk, and compare it with the vector result
+    for(int c = 0; c < n; c += VERIFY_CHUNK)
+    {
+        double expected[VERIFY_CHUNK];
+        int m = fmin(n - c, VERIFY_CHUNK);
+        memcpy(expected, a + c, sizeof(double) * m);
+        addConstantScalar(expected, k, m);
+        active_kernels->add_constant(a + c, k, m);
+        compareDoubles(a + c, expected, m);
+    }
+}
+
+// a[i] += k for i in [0, n), on integers
+void addConstantInt(int* a, int k, int n)
+{
+    if(!verify_simd)
+    {
+        active_kernels->add_constant_int(a, k, n);
+        return;
+    }
+
+    // Run the scalar kernel on a copy of each chunk, and compare it with the vector result
+    for(int c = 0; c < n; c += VERIFY_CHUNK)
+    {
+        int expected[VERIFY_CHUNK];
+        int m = fmin(n - c, VERIFY_CHUNK);
+        memcpy(expected, a + c, sizeof(int) * m);
+        addConstantIntScalar(expected, k, m);
+        active_kernels->add_constant_int(a + c, k, m);
+        compareInts(a + c, expected, m);
+    }
+}
+
+// Slow a[i] down by d for i in [0, n)
+void applyDrag(double* a, double d, int n)
+{
+    if(!verify_simd)
+    {
+        active_kernels->apply_drag(a, d, n);
+        return;
+    }
+
+    // Run the scalar kernel on a copy of each chunk, and compare it with the vector result
+    for(int c = 0; c < n; c += VERIFY_CHUNK)
+    {
+        double expected[VERIFY_CHUNK];
+        int m = fmin(n - c, VERIFY_CHUNK);
+        memcpy(expected, a + c, sizeof(double) * m);
+        applyDragScalar(expected, d, m);
+        active_kernels->apply_drag(a + c, d, m);
+        compareDoubles(a + c, expected, m);
+    }
+}
@@ -1,9 +1,26 @@
 #include "../headers/constants.h"
 #include "../headers/sound.h"
 #include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/trace.h"
+#include "../headers/batch.h"
+#include "../headers/replay.h"
+#include "../headers/level.h"
+#include "../headers/world.h"
+
+// Struct for the animation of one sprite action, precomputed from the sprite's frame sections
+struct animation
+{
+    int first;                  // first animation frame of the action
+    int end;                    // one past the last animation frame of the action
+    double rate;                // how many animation frames to advance each tick
+};
 
 // Struct for sprite meta information
-typedef struct sprite_metainfo
+struct sprite_metainfo
 {
     int width;                  // width in pixels
     int height;                 // height in pixels
@@ -12,12 +29,14 @@ typedef struct sprite_metainfo
     SDL_Rect* rbounds;          // arrays of bounding boxes (one for each direction), for collision checking
     SDL_Rect* lbounds;          // with origin in the upper-left, given relative to the sprite's xy-position
     int sheet_position;         // y-position of sprite on the sprite sheet
-    int* frame_sections;        // array containing the number of animation frames for each sprite action
+    int num_actions;            // number of animation actions on the sprite sheet
+    struct animation* anims;    // array of animations, indexed by action (MOVE, JUMP, etc)
+    SDL_Rect* clips;            // array of sprite sheet clips, indexed by animation frame
     int power;                  // how much damage this sprite does in a collision
     int max_hp;                 // the maximum hp of the sprite
-    int type;                   // what kind of sprite is this (HUMANOID, SPELL, PARTICLE)
+    int type;                   // what kind of sprite is this (HUMANOID, SPELL)
     int id;                     // what sprite is this (FIREBALL, GUY, etc)
-}* SpriteInfo;
+};
 
 // Struct for spell meta information
 typedef struct spell_metainfo
@@ -26,221 +45,344 @@ typedef struct spell_metainfo
     int cast_time;              // how long does it take to cast this spell
     int finish_time;            // at what point in the casting animation is the spell launched
     int cooldown;               // how many frames before the spell is available again
-    void (*on_launch)(Sprite);  // function that's called when the spell is launched
-    void (*on_collide)(Sprite); // function that's called when the spell collides
+    void (*on_launch)(World, Sprite);   // function that's called when the spell is launched
+    void (*on_collide)(World, Sprite);  // function that's called when the spell collides
 }* SpellInfo;
 
-// Struct for a currently active sprite
-struct sprite
-{
-    // Meta info
-    SpriteInfo meta;            // meta info for this sprite (see above)
-
-    // Positional info
-    double x_pos;               // in-game x-coord
-    double y_pos;               // in-game y-coord
-    double x_vel;               // x-velocity
-    double y_vel;               // y-velocity
-    bool direction;             // direction currently facing
-    int angle;                  // angle of orientation
-
-    // Action info
-    int hp;                     // current hp
-    int spawning;               // number of frames left in spawn animation
-    int colliding;              // number of frames left in collision
-    int casting;                // number of frames left to cast spell
-    int lifetime;               // number of frames before this sprite dies automatically
-    int* cooldowns;             // array of spell cooldowns
-    int spell;                  // spell currently in use
-    int action;                 // which animation is the sprite in (MOVE, JUMP, etc)
-    bool action_change;         // has sprite's action changed to a different one this frame
-    double frame;               // which animation frame should be rendered on the sprite sheet
-};
+SDL_Texture* sprite_sheet;      // Texture containing all sprites
+SpriteInfo* sprite_info;        // Array of meta info structs for sprites, indexed by identities enum (sprite.h)
+SpellInfo* spell_info;          // Array of meta info structs for spells, indexed by identities enum (sprite.h)
+
+/* SPRITE POOL */
 
-// Struct for a linked list of sprites
-typedef struct ele
+// Thread every record of a world's sprite pool onto the free list, leaving no sprites active
+void initSpritePool(World w)
 {
-    Sprite sp;                  // sprite at this node
-    struct ele* next;           // next node
-}* SpriteList;
+    w->free_records = NO_RECORD;
+    for(int k = MAX_SPRITES - 1; k >= 0; k--)
+    {
+        w->sprite_pool[k].next = w->free_records;
+        w->free_records = k;
+    }
+    w->active.count = 0;
+    w->guys[0] = NO_RECORD;
+    w->guys[1] = NO_RECORD;
+}
 
-SDL_Texture* sprite_sheet;       // Texture containing all sprites
-SpriteList active_sprites;       // Linked list of currently active sprites
-SpriteInfo* sprite_info;        // Array of meta info structs for sprites, indexed by identities enum (sprite.h)
-SpellInfo* spell_info;          // Array of meta info structs for spells, indexed by identities enum (sprite.h)
+// Take a record off the free list, returning its pool index, or NO_RECORD if the pool is exhausted
+static int allocRecord(World w)
+{
+    int k = w->free_records;
+    if(k == NO_RECORD) return NO_RECORD;
+    w->free_records = w->sprite_pool[k].next;
+    w->sprite_pool[k].next = NO_RECORD;
+    return k;
+}
 
-Sprite guys[2] = {NULL, NULL};  // Permanent storage for the guy sprites
+// Return the record at a pool index to the free list
+static void releaseRecord(World w, int k)
+{
+    w->sprite_pool[k].next = w->free_records;
+    w->free_records = k;
+}
+
+// Get the record of the sprite in a slot
+static Sprite slotRecord(World w, int i)
+{
+    return &w->sprite_pool[w->active.record[i]];
+}
+
+// Get the record of a guy
+static Sprite guyRecord(World w, int guy)
+{
+    return &w->sprite_pool[w->guys[guy]];
+}
+
+// Get the slot a guy's state is in
+int guySlot(World w, int guy)
+{
+    return w->sprite_pool[w->guys[guy]].slot;
+}
+
+// Move the state of the sprite in one slot of the sprite store to another
+static void moveSlot(World w, int to, int from)
+{
+    w->active.record[to] = w->active.record[from];
+    slotRecord(w, to)->slot = to;
+    w->active.id[to] = w->active.id[from];
+    w->active.type[to] = w->active.type[from];
+    w->active.x_pos[to] = w->active.x_pos[from];
+    w->active.y_pos[to] = w->active.y_pos[from];
+    w->active.x_prev[to] = w->active.x_prev[from];
+    w->active.y_prev[to] = w->active.y_prev[from];
+    w->active.x_vel[to] = w->active.x_vel[from];
+    w->active.y_vel[to] = w->active.y_vel[from];
+    w->active.direction[to] = w->active.direction[from];
+    w->active.angle[to] = w->active.angle[from];
+    w->active.hp[to] = w->active.hp[from];
+    w->active.spawning[to] = w->active.spawning[from];
+    w->active.colliding[to] = w->active.colliding[from];
+    w->active.casting[to] = w->active.casting[from];
+    w->active.lifetime[to] = w->active.lifetime[from];
+    w->active.action[to] = w->active.action[from];
+    w->active.action_change[to] = w->active.action_change[from];
+    w->active.frame[to] = w->active.frame[from];
+}
 
 /* SPRITE CONSTRUCTOR */
 
 // Initialize a sprite with its on-screen location and stats
-void spawnSprite(int id, double x, double y, double xv, double yv, bool dir, int angle, int spawning, int life)
-{
-    // Set sprite fields
-    Sprite sp = (Sprite) malloc(sizeof(struct sprite));
-    sp->meta = sprite_info[id];
-    sp->hp = sp->meta->max_hp;
-    sp->angle = angle; sp->direction = dir;
-    sp->x_pos = x;     sp->y_pos = y;
-    sp->x_vel = xv;    sp->y_vel = yv;
-    sp->casting = 0;   sp->colliding = 0;
-    sp->spell = 0;     sp->spawning = spawning;
-    sp->frame = 0;     sp->action = SPAWN;
-    sp->lifetime = life;
-
-    // Only human sprites have cooldowns
-    sp->cooldowns = NULL;
-    if(sp->meta->type == HUMANOID) sp->cooldowns = (int*) calloc(NUM_SPELLS, sizeof(int));
-
-    // Add sprite to linked list of active sprites
-    struct ele* new_sprite = (struct ele*) malloc(sizeof(struct ele));
-    new_sprite->sp = sp;
-    new_sprite->next = NULL;
-    if(active_sprites != NULL) new_sprite->next = active_sprites;
-    active_sprites = new_sprite;
+void spawnSprite(World w, int id, double x, double y, double xv, double yv, bool dir, int angle, int spawning, int life)
+{
+    // Grab a record from the sprite pool - if it's exhausted, the sprite simply isn't spawned
+    int k = allocRecord(w);
+    if(k == NO_RECORD) return;
+
+    // Set sprite record fields
+    Sprite sp = &w->sprite_pool[k];
+    sp->spell = 0;
+    for(int i = 0; i < NUM_SPELLS; i++) sp->cooldowns[i] = 0;
+
+    // Add sprite state to the end of the sprite store
+    int i = w->active.count++;
+    if(w->active.count > w->pool_high_water) w->pool_high_water = w->active.count;
+    sp->slot = i;
+    w->active.record[i] = k;
+    w->active.id[i] = id;                  w->active.type[i] = sprite_info[id]->type;
+    w->active.hp[i] = sprite_info[id]->max_hp;
+    w->active.angle[i] = angle;            w->active.direction[i] = dir;
+    w->active.x_pos[i] = x;                w->active.y_pos[i] = y;
+    w->active.x_prev[i] = x;               w->active.y_prev[i] = y;
+    w->active.x_vel[i] = xv;               w->active.y_vel[i] = yv;
+    w->active.casting[i] = 0;              w->active.colliding[i] = 0;
+    w->active.spawning[i] = spawning;      w->active.lifetime[i] = life;
+    w->active.frame[i] = 0;                w->active.action[i] = SPAWN;
+    w->active.action_change[i] = false;
 
     // If sprite is a guy store a reference to him
-    if(sp->meta->id == GUY)
+    if(id == GUY)
     {
-        if(!guys[0]) guys[0] = sp;
-        else         guys[1] = sp;
+        if(w->guys[0] == NO_RECORD) w->guys[0] = k;
+        else                        w->guys[1] = k;
     }
 }
 
 /* SETTERS */
 
 // Set a sprite's action
-static void setAction(Sprite sp, int action)
+static void setAction(World w, int i, int action)
 {
-    if(sp->action != action) sp->action_change = true;
-    sp->action = action;
+    if(w->active.action[i] != action) w->active.action_change[i] = true;
+    w->active.action[i] = action;
 }
 
-// Teleport a sprite to a different location
-static void setPosition(Sprite sp, double x, double y)
+// Teleport a sprite to a different location (without interpolating from where it was)
+static void setPosition(World w, int i, double x, double y)
 {
-    sp->x_pos = x;
-    sp->y_pos = y;
+    w->active.x_pos[i] = x;
+    w->active.y_pos[i] = y;
+    w->active.x_prev[i] = x;
+    w->active.y_prev[i] = y;
 }
 
 // Remove a sprite's velocity
-static void stopSprite(Sprite sp)
+static void stopSprite(World w, int i)
 {
-    sp->x_vel = 0;
-    sp->y_vel = 0;
+    w->active.x_vel[i] = 0;
+    w->active.y_vel[i] = 0;
 }
 
 // Hide a guy in the top right corner of the screen (Guys can't be despawned)
-void hideGuy(int guy)
+void hideGuy(World w, int guy)
 {
-    setPosition(guys[guy], SCREEN_WIDTH+20, 0);
-    stopSprite(guys[guy]);
-    guys[guy]->hp = 1;
+    int i = guySlot(w, guy);
+    setPosition(w, i, SCREEN_WIDTH+20, 0);
+    stopSprite(w, i);
+    w->active.hp[i] = 1;
 }
 
 // Reset the fields of the Guys after a match ends
-void resetGuy(int guy, int x_pos, int y_pos)
+void resetGuy(World w, int guy, int x_pos, int y_pos)
 {
-    guys[guy]->hp = 100;
-    guys[guy]->hp = 100;
-    for(int i = 0; i < NUM_SPELLS; i++) guys[guy]->cooldowns[i] = 0;
-    setPosition(guys[guy], x_pos, y_pos);
-    stopSprite(guys[guy]);
-    if(guy) guys[guy]->direction = LEFT;
-    else    guys[guy]->direction = RIGHT;
+    int i = guySlot(w, guy);
+    w->active.hp[i] = 100;
+    for(int s = 0; s < NUM_SPELLS; s++) guyRecord(w, guy)->cooldowns[s] = 0;
+    setPosition(w, i, x_pos, y_pos);
+    stopSprite(w, i);
+    if(guy) w->active.direction[i] = LEFT;
+    else    w->active.direction[i] = RIGHT;
 }
 
 /* GETTERS */
 
-// Get an array of percentages of a guy's cooldowns
-double* getCooldowns(int guy)
+// Fill an array of NUM_SPELLS + 1 doubles with percentages of a guy's cooldowns
+void getCooldowns(World w, int guy, double* cooldown_percentages)
 {
-    // Make sure the malloc'd array is still collected even if the Guy doesn't exist
-    double* cooldown_percentages = (double*) malloc(sizeof(double) * (NUM_SPELLS + 1));
-    if(!guys[guy]) return cooldown_percentages;
-
-    // Get cooldown percentages
+    // Get cooldown percentages (all cooled down if the Guy doesn't exist)
     for(int i = 0; i < NUM_SPELLS; i++)
     {
-        cooldown_percentages[i] = guys[guy]->cooldowns[i] / (double) spell_info[i]->cooldown;
+        if(w->guys[guy] == NO_RECORD) cooldown_percentages[i] = 0;
+        else                          cooldown_percentages[i] = guyRecord(w, guy)->cooldowns[i] / (double) spell_info[i]->cooldown;
     }
 
     // Hack to denote an end of the array
     cooldown_percentages[NUM_SPELLS] = -1;
-    return cooldown_percentages;
+}
+
+// Get the texture containing all sprites
+SDL_Texture* getSpriteSheet()
+{
+    return sprite_sheet;
+}
+
+// Get the most sprites that have ever been active at once
+int getPoolHighWater(World w)
+{
+    return w->pool_high_water;
+}
+
+// Get the total number of sprite pairs that could have collided, that were checked, and that collided
+void getCollisionStats(World w, long long* possible, long long* tested, long long* hits)
+{
+    *possible = w->pairs_possible;
+    *tested = w->pairs_tested;
+    *hits = w->pairs_hit;
+}
+
+// Get how many times a spell has been cast, how many times it has hit a guy, and how much damage it has done to guys
+void getSpellStats(World w, int spell, int* casts, int* hits, int* damage)
+{
+    *casts = w->spell_casts[spell];
+    *hits = w->spell_hits[spell];
+    *damage = w->spell_damage[spell];
+}
+
+// Mix the gameplay state of every active sprite into a hash (animation frames and interpolation
+// positions are left out, since they only affect what's drawn)
+Uint64 hashSprites(World w, Uint64 hash)
+{
+    hash = hashBytes(hash, &w->active.count, sizeof(int));
+    for(int i = 0; i < w->active.count; i++)
+    {
+        Sprite sp = slotRecord(w, i);
+        int k = w->active.record[i];
+        int guy = k == w->guys[0] ? 0 : k == w->guys[1] ? 1 : -1;
+        hash = hashBytes(hash, &guy, sizeof(int));
+        hash = hashBytes(hash, &w->active.id[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.x_pos[i], sizeof(double));
+        hash = hashBytes(hash, &w->active.y_pos[i], sizeof(double));
+        hash = hashBytes(hash, &w->active.x_vel[i], sizeof(double));
+        hash = hashBytes(hash, &w->active.y_vel[i], sizeof(double));
+        hash = hashBytes(hash, &w->active.direction[i], sizeof(bool));
+        hash = hashBytes(hash, &w->active.angle[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.hp[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.spawning[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.colliding[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.casting[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.lifetime[i], sizeof(int));
+        hash = hashBytes(hash, &w->active.action[i], sizeof(int));
+        hash = hashBytes(hash, &sp->spell, sizeof(int));
+        hash = hashBytes(hash, sp->cooldowns, sizeof(sp->cooldowns));
+    }
+    return hash;
 }
 
 // Get a guy's health remaining
-int getHealth(int guy)
+int getHealth(World w, int guy)
 {
     // Make sure something is returned even if the Guy doesn't exist
-    if(!guys[guy]) return 0;
-    return guys[guy]->hp;
+    if(w->guys[guy] == NO_RECORD) return 0;
+    return w->active.hp[guySlot(w, guy)];
 }
 
 // Get the x coordinate of a sprite's center
-static double xCenter(Sprite sp)
+static double xCenter(World w, int i)
 {
-    return (sp->x_pos + (double)sp->meta->width/2);
+    return (w->active.x_pos[i] + (double)sprite_info[w->active.id[i]]->width/2);
 }
 
 // Get the y coordinate of a sprite's center
-static double yCenter(Sprite sp)
+static double yCenter(World w, int i)
 {
-    return (sp->y_pos + (double)sp->meta->height/2);
+    return (w->active.y_pos[i] + (double)sprite_info[w->active.id[i]]->height/2);
+}
+
+// Get which bounding boxes a kind of sprite uses when facing a direction
+static SDL_Rect* getBoundsFacing(int id, bool direction)
+{
+    if(direction == RIGHT) return sprite_info[id]->rbounds;
+    return sprite_info[id]->lbounds;
 }
 
 // Get which bounding boxes should be used by this sprite
-static SDL_Rect* getBounds(Sprite sp)
+static SDL_Rect* getBounds(World w, int i)
 {
-    if(sp->direction == RIGHT) return sp->meta->rbounds;
-    return sp->meta->lbounds;
+    return getBoundsFacing(w->active.id[i], w->active.direction[i]);
 }
 
 // Return true if a sprite is touching the ground
-static bool onGround(Sprite sp, int* platforms)
+static bool onGround(World w, int i, int* platforms)
 {
-    int middle = xCenter(sp);
-    return (sp->y_pos + sp->meta->height >= platforms[1]) && (middle > platforms[2] && middle < platforms[3]);
+    int middle = xCenter(w, i);
+    return (w->active.y_pos[i] + sprite_info[w->active.id[i]]->height >= platforms[1]) && (middle > platforms[2] && middle < platforms[3]);
 }
 
 // Return -1 unless sprite has landed on a platform (including the ground)
-static int onPlatform(Sprite sp, int* platforms)
+static int onPlatform(World w, int i, int* platforms)
 {
     int numPlatforms = platforms[0];
-    int middle = xCenter(sp);
-    for(int i = 1; i < numPlatforms*3 + 1; i += 3)
+    int middle = xCenter(w, i);
+    int height = sprite_info[w->active.id[i]]->height;
+    double y_vel = w->active.y_vel[i];
+    for(int p = 1; p < numPlatforms*3 + 1; p += 3)
     {
         // Platform land check - AABB and a positive y-velocity
-        if(sp->y_vel >= 0 && fabs(platforms[i] - (sp->y_pos + sp->meta->height)) <= fabs(sp->y_vel)
-        && middle > platforms[i+1] && middle < platforms[i+2])
+        if(y_vel >= 0 && fabs(platforms[p] - (w->active.y_pos[i] + height)) <= fabs(y_vel)
+        && middle > platforms[p+1] && middle < platforms[p+2])
         {
             // Return a new position for the sprite such that it is directly on the platform
-            return platforms[i] - sp->meta->height;
+            return platforms[p] - height;
         }
     }
     return -1;
 }
 
+// Check whether a guy has a platform (or the ground) somewhere under him to land on
+bool overPlatform(World w, int guy, int* platforms)
+{
+    if(w->guys[guy] == NO_RECORD) return false;
+    int i = guySlot(w, guy);
+    int middle = xCenter(w, i);
+    double feet = w->active.y_pos[i] + sprite_info[w->active.id[i]]->height;
+    for(int p = 1; p < platforms[0]*3 + 1; p += 3)
+    {
+        if(platforms[p] >= feet - 1 && middle > platforms[p+1] && middle < platforms[p+2]) return true;
+    }
+    return false;
+}
+
 // Return -1 unless sprite is touching a wall
-static int touchingWall(Sprite sp, int* walls)
+static int touchingWall(World w, int i, int* walls)
 {
     int numWalls = walls[0];
-    for(int i = 1; i < numWalls*3 + 1; i += 3)
+    double x = w->active.x_pos[i];
+    double y = w->active.y_pos[i];
+    SpriteInfo meta = sprite_info[w->active.id[i]];
+    for(int k = 1; k < numWalls*3 + 1; k += 3)
     {
         // AABB check - if it passes, there's a wall collision
-        if(walls[i] < sp->x_pos + sp->meta->width && walls[i] > sp->x_pos
-        && walls[i+1] < sp->y_pos + sp->meta->height && walls[i+2] > sp->y_pos)
+        if(walls[k] < x + meta->width && walls[k] > x
+        && walls[k+1] < y + meta->height && walls[k+2] > y)
         {
             // Determine which side of the wall was collided with and return a new position
             // for the sprite such that it would no longer be inside the wall
-            if(fabs(walls[i] - sp->x_pos) < fabs(walls[i] - (sp->x_pos + sp->meta->width)))
+            if(fabs(walls[k] - x) < fabs(walls[k] - (x + meta->width)))
             {
-                return walls[i];
+                return walls[k];
             }
             else
             {
-                return walls[i] - sp->meta->width;
+                return walls[k] - meta->width;
             }
         }
     }
@@ -248,244 +390,247 @@ static int touchingWall(Sprite sp, int* walls)
 }
 
 // Checks if an active sprite is dead and needs to be unloaded
-static bool isDead(Sprite sp)
+static bool isDead(World w, int i)
 {
     // If a sprite is too far off screen, it's dead
-    double x = sp->x_pos;
-    double y = sp->y_pos;
+    double x = w->active.x_pos[i];
+    double y = w->active.y_pos[i];
     if(x < -500 || x > SCREEN_WIDTH+500 || y <= -500 || y >= SCREEN_HEIGHT+100) return 1;
 
     // If a sprite is out of hp and has finished its collision animation, it's dead
-    if(sp->hp == 0 && sp->colliding == 1) return 1;
+    if(w->active.hp[i] == 0 && w->active.colliding[i] == 1) return 1;
 
     // If a sprite has run out of lifetime, it's dead
-    if(sp->lifetime == 1) return 1;
+    if(w->active.lifetime[i] == 1) return 1;
 
     return 0;
 }
 
 /* SPRITE EVENTS */
 
-// In 1-player mode, process AI decisions
-void takeCPUAction()
-{
-    // Human player
-    int player = 0;
-    Sprite player_guy = guys[player];
-
-    // Cpu player
-    int cpu = 1;
-    Sprite cpu_guy = guys[cpu];
-
-    // Walk towards player, but maintain a healthy distance
-    int towards_player = cpu_guy->x_pos < player_guy->x_pos;
-    if(fabs(cpu_guy->x_pos - player_guy->x_pos) >= 150) walk(cpu, towards_player);
-
-    // Generally face the player
-    if(cpu_guy->action == IDLE) cpu_guy->direction = towards_player;
-
-    // Randomly jump
-    if(get_rand() <= 0.003) jump(cpu);
-
-    // Randomly cast spells
-    if(get_rand() <= 0.015) cast(cpu, (int) (get_rand() * NUM_SPELLS));
-}
-
 // Attempt to walk in a direction after a keyboard input
-bool walk(int guy, bool left_or_right)
+bool walk(World w, int guy, bool left_or_right)
 {
     // Guy can only walk if he's not casting or colliding (can still move left/right in midair)
-    if(!(guys[guy]->casting || guys[guy]->colliding))
+    int i = guySlot(w, guy);
+    if(!(w->active.casting[i] || w->active.colliding[i]))
     {
         // Guy has less control in midair
         double speed = 0.45;
-        if(guys[guy]->y_vel != 0) speed = 0.35;
+        if(w->active.y_vel[i] != 0) speed = 0.35;
         double top_speed = 4.5;
 
         // Update velocity and direction facing based on direction of walk
         if(left_or_right == LEFT)
         {
-            guys[guy]->x_vel = fmax(guys[guy]->x_vel - speed, -1 * top_speed);
+            w->active.x_vel[i] = fmax(w->active.x_vel[i] - speed, -1 * top_speed);
         }
         else
         {
-            guys[guy]->x_vel = fmin(guys[guy]->x_vel + speed, top_speed);
+            w->active.x_vel[i] = fmin(w->active.x_vel[i] + speed, top_speed);
         }
-        guys[guy]->direction = left_or_right;
+        w->active.direction[i] = left_or_right;
         return 1;
     }
     return 0;
 }
 
 // Attempt to jump after a keyboard input
-bool jump(int guy)
+bool jump(World w, int guy)
 {
     // Guy can only jump if he's not casting, colliding, or jumping
-    if(!(guys[guy]->casting || guys[guy]->colliding) && guys[guy]->action != JUMP)
+    int i = guySlot(w, guy);
+    if(!(w->active.casting[i] || w->active.colliding[i]) && w->active.action[i] != JUMP)
     {
-        guys[guy]->y_vel += -10.1;
+        w->active.y_vel[i] += -10.1;
         return 1;
     }
     return 0;
 }
 
 // Attempt to cast a spell after a keyboard input
-bool cast(int guy, int spell)
+bool cast(World w, int guy, int spell)
 {
     // Guy can only cast a spell if it's off cooldown and he's not casting, colliding, or jumping
-    if(!(guys[guy]->casting || guys[guy]->colliding) && !guys[guy]->cooldowns[spell] && guys[guy]->action != JUMP)
+    int i = guySlot(w, guy);
+    if(!(w->active.casting[i] || w->active.colliding[i]) && !guyRecord(w, guy)->cooldowns[spell] && w->active.action[i] != JUMP)
     {
-        guys[guy]->casting = spell_info[spell]->cast_time;
-        guys[guy]->spell = spell;
+        w->active.casting[i] = spell_info[spell]->cast_time;
+        guyRecord(w, guy)->spell = spell;
 
         // For rockfall, guy should face in the direction of the other guy
-        if(spell == ROCKFALL) guys[guy]->direction = (guys[guy]->x_pos <= guys[(int)!guy]->x_pos);
+        if(spell == ROCKFALL) w->active.direction[i] = (w->active.x_pos[i] <= w->active.x_pos[guySlot(w, (int)!guy)]);
         return 1;
     }
     return 0;
 }
 
 // Action function for launching a fireball (stored as fxn ptr in spellInfo)
-static void launchFireball(Sprite sp)
+static void launchFireball(World w, Sprite sp)
 {
     // Starting position and velocity of the fireball
-    double x = sp->x_pos;
-    double y = sp->y_pos + 28;
-    double xv = convert(sp->direction) * 1.2;
-    if(sp->direction == RIGHT) x += sp->meta->width - 4;
-    else                       x -= sprite_info[FIREBALL]->width - 4;
+    int i = sp->slot;
+    bool dir = w->active.direction[i];
+    double x = w->active.x_pos[i];
+    double y = w->active.y_pos[i] + 28;
+    double xv = convert(dir) * 1.2;
+    if(dir == RIGHT) x += sprite_info[w->active.id[i]]->width - 4;
+    else             x -= sprite_info[FIREBALL]->width - 4;
 
     // Spawn the fireball
-    spawnSprite(FIREBALL, x, y, xv, 0, sp->direction, 0, 0, 0);
+    spawnSprite(w, FIREBALL, x, y, xv, 0, dir, 0, 0, 0);
 }
 
 // Helper function to launch a single ice missile
-static void launchIceshockSingle(Sprite sp, double x_dist, double y_dist, double x_speed, double y_speed, int dir)
+static void launchIceshockSingle(World w, Sprite sp, double x_dist, double y_dist, double x_speed, double y_speed, int dir)
 {
     // Starting orientation/side-of-caster of the missile
     int side = convert(dir);
     int angle = (int) (57.296 * atan(y_speed / (side * x_speed)));
 
     // Starting position of the missile
-    double ice_xpos = (side*x_dist)+sp->x_pos+sp->meta->width/4-3;
-    double ice_ypos = sp->y_pos-y_dist;
-
-    // Spawn one missile and four small particles around it
-    spawnSprite(ICESHOCK, ice_xpos, ice_ypos, side * x_speed, y_speed, dir, angle, 0, 0);
-    for(int j = 0; j < 4; j++)
+    double ice_xpos = (side*x_dist)+w->active.x_pos[sp->slot]+sprite_info[w->active.id[sp->slot]]->width/4-3;
+    double ice_ypos = w->active.y_pos[sp->slot]-y_dist;
+
+    // Spawn one missile and four small particles around it (fewer when the particle budget is cut)
+    spawnSprite(w, ICESHOCK, ice_xpos, ice_ypos, side * x_speed, y_speed, dir, angle, 0, 0);
+    double r[4 * 4];
+    fillRand(&w->rng, RNG_COSMETIC, r, 4 * 4);
+    int count = budgetBurst(w, 4);
+    for(int j = 0; j < count; j++)
     {
-        double ptc_x = ice_xpos + (get_rand() - 0.5) * 10;
-        double ptc_y = ice_ypos + (get_rand() - 0.5) * 10;
-        double ptc_xv = side * (x_speed * get_rand() + 2);
-        double ptc_yv = y_speed * get_rand() - x_speed;
-        spawnSprite(ICESHOCK_P1, ptc_x, ptc_y, ptc_xv, ptc_yv, dir, 0, 0, 0);
+        double* rj = r + j * 4;
+        double ptc_x = ice_xpos + (rj[0] - 0.5) * 10;
+        double ptc_y = ice_ypos + (rj[1] - 0.5) * 10;
+        double ptc_xv = side * (x_speed * rj[2] + 2);
+        double ptc_yv = y_speed * rj[3] - x_speed;
+        emitParticle(w, ICESHOCK_P1, ptc_x, ptc_y, ptc_xv, ptc_yv, dir, 0, 0);
     }
 }
 
 // Action function for launching an iceshock (stored as fxn ptr in spellInfo)
-static void launchIceshock(Sprite sp)
+static void launchIceshock(World w, Sprite sp)
 {
     for(int dir = LEFT; dir <= RIGHT; dir++)
     {
-        launchIceshockSingle(sp, 20, 0, 8, -4, dir);
-        launchIceshockSingle(sp, 10, 10, 5, -5, dir);
-        launchIceshockSingle(sp, 5, 20, 2, -6, dir);
+        launchIceshockSingle(w, sp, 20, 0, 8, -4, dir);
+        launchIceshockSingle(w, sp, 10, 10, 5, -5, dir);
+        launchIceshockSingle(w, sp, 5, 20, 2, -6, dir);
     }
 }
 
 // Action function for launching rockfall (stored as fxn ptr in spellInfo)
-static void launchRockfall(Sprite sp)
+static void launchRockfall(World w, Sprite sp)
 {
     // Get position of the other guy
-    int other_guy_idx = (sp == guys[0]);
-    Sprite other_guy = guys[other_guy_idx];
+    int other_guy_idx = (sp == guyRecord(w, 0));
+    int other_guy = guySlot(w, other_guy_idx);
 
     // Set starting position of rock
-    int x = xCenter(other_guy) - sprite_info[ROCKFALL]->width / 2;
+    int x = xCenter(w, other_guy) - sprite_info[ROCKFALL]->width / 2;
     x = fmin(fmax(x, 60), 964 - sprite_info[ROCKFALL]->width); // Avoid spawning inside trees on forest map
-    int y = other_guy->y_pos - 250;
+    int y = w->active.y_pos[other_guy] - 250;
 
     // Spawn the rock
-    spawnSprite(ROCKFALL, x, y, 0, -1, RIGHT, 0, 20, 0);
+    spawnSprite(w, ROCKFALL, x, y, 0, -1, RIGHT, 0, 20, 0);
 }
 
 // Action function for launching darkedge (stored as fxn ptr in spellInfo)
-static void launchDarkedge(Sprite sp)
+static void launchDarkedge(World w, Sprite sp)
 {
     // base positions and velocity of spears
-    double x_pos = sp->x_pos - (!sp->direction * 33);
-    double y_pos = sp->y_pos - 45;
+    bool dir = w->active.direction[sp->slot];
+    double x_pos = w->active.x_pos[sp->slot] - (!dir * 33);
+    double y_pos = w->active.y_pos[sp->slot] - 45;
 
-    double x_vel = 0.1 * convert(sp->direction);
+    double x_vel = 0.1 * convert(dir);
     double y_vel = 0.025;
 
     // Spawn four dark spears above caster
     for(int i = 0; i < 4; i++)
     {
         int angle = (int) (57.296 * atan(y_vel / x_vel));
-        spawnSprite(DARKEDGE, x_pos, y_pos - i*45, x_vel, y_vel, sp->direction, angle, 33, 0);
+        spawnSprite(w, DARKEDGE, x_pos, y_pos - i*45, x_vel, y_vel, dir, angle, 33, 0);
     }
 }
 
 // Action function for launching arcsurge (stored as fxn ptr in spellInfo)
-static void launchArcsurge(Sprite sp)
+static void launchArcsurge(World w, Sprite sp)
 {
+    traceBegin("launchArcsurge");
+
     // Position of the lightning bolt
-    double x = sp->x_pos;
-    double y = sp->y_pos - 1;
-    if(sp->direction == RIGHT) x += sp->meta->width - 6;
-    else                       x -= sprite_info[ARCSURGE]->width - 6;
+    int i = sp->slot;
+    bool dir = w->active.direction[i];
+    double x = w->active.x_pos[i];
+    double y = w->active.y_pos[i] - 1;
+    if(dir == RIGHT) x += sprite_info[w->active.id[i]]->width - 6;
+    else             x -= sprite_info[ARCSURGE]->width - 6;
 
     // Caster is blown back by the launch
-    sp->x_vel = -6 * convert(sp->direction);
+    w->active.x_vel[i] = -6 * convert(dir);
 
     // Spawn lightning next to sprite, on the side the sprite is facing
-    spawnSprite(ARCSURGE, x, y, 0, 0, sp->direction, 0, 0, 20);
+    spawnSprite(w, ARCSURGE, x, y, 0, 0, dir, 0, 0, 20);
 
-    // Particles shoot out in the direction the spell was cast
-    double p_x = x + (sp->direction * sprite_info[ARCSURGE]->width);
+    // Particles shoot out in the direction the spell was cast (fewer when the particle budget is cut)
+    double p_x = x + (dir * sprite_info[ARCSURGE]->width);
     double p_y = y + sprite_info[ARCSURGE]->height / 2;
-    for(int i = 0; i < 30; i++)
+    double r[30 * 3];
+    fillRand(&w->rng, RNG_COSMETIC, r, 30 * 3);
+    int count = budgetBurst(w, 30);
+    for(int p = 0; p < count; p++)
     {
+        double* rp = r + p * 3;
         double top_speed = 5;
-        double p_xv = (1 + get_rand()) * 3.5 * convert(sp->direction);
-        double p_yv = (top_speed - fabs(p_xv)) * ((get_rand() - 0.5) * 2);
-        spawnSprite(ARCSURGE_P1, p_x, p_y, p_xv, p_yv, sp->direction, 0, 0, 10 + get_rand() * 20);
+        double p_xv = (1 + rp[0]) * 3.5 * convert(dir);
+        double p_yv = (top_speed - fabs(p_xv)) * ((rp[1] - 0.5) * 2);
+        emitParticle(w, ARCSURGE_P1, p_x, p_y, p_xv, p_yv, dir, 0, 10 + rp[2] * 20);
     }
+    traceEnd("launchArcsurge");
 }
 
 // Generic actions for when any spell collides with something (always slows down and dies)
-static void collideGeneric(Sprite sp)
+static void collideGeneric(World w, Sprite sp)
 {
-    sp->colliding = 20;
-    sp->hp = 0;
-    sp->x_vel *= 0.05;
-    sp->y_vel *= 0.05;
+    int i = sp->slot;
+    w->active.colliding[i] = 20;
+    w->active.hp[i] = 0;
+    w->active.x_vel[i] *= 0.05;
+    w->active.y_vel[i] *= 0.05;
 }
 
 // Action function for a rockfall collision (stored as fxn ptr in spellInfo)
-static void collideRockfall(Sprite sp)
+static void collideRockfall(World w, Sprite sp)
 {
-    // Set collided and slow the sprite down
-    collideGeneric(sp);
+    traceBegin("collideRockfall");
 
-    // Spawn particles
-    for(int i = 0; i < 8; i++)
+    // Set collided and slow the sprite down
+    collideGeneric(w, sp);
+
+    // Spawn particles (fewer when the particle budget is cut)
+    int i = sp->slot;
+    double r[8 * 10];
+    fillRand(&w->rng, RNG_COSMETIC, r, 8 * 10);
+    int count = budgetBurst(w, 8);
+    for(int p = 0; p < count; p++)
     {
-        int x_dir = convert(i < 4);
-        double x = xCenter(sp);
-        double y = yCenter(sp);
-        double xv = x_dir * sp->y_vel;
-        double yv = sp->y_vel * -2;
-        int a = get_rand();
-        spawnSprite(ROCKFALL_P1, x+(get_rand()-0.5)*40, y, xv + x_dir*5*get_rand(), yv-7*get_rand(), 0, a, 0, 0);
-        spawnSprite(ROCKFALL_P2, x+(get_rand()-0.5)*40, y, xv + x_dir*5*get_rand(), yv-7*get_rand(), 0, a, 0, 0);
-        spawnSprite(ROCKFALL_P2, x+(get_rand()-0.5)*40, y, xv + x_dir*5*get_rand(), yv-7*get_rand(), 0, a, 0, 0);
+        double* rp = r + p * 10;
+        int x_dir = convert(p < 4);
+        double x = xCenter(w, i);
+        double y = yCenter(w, i);
+        double xv = x_dir * w->active.y_vel[i];
+        double yv = w->active.y_vel[i] * -2;
+        int a = rp[0];
+        emitParticle(w, ROCKFALL_P1, x+(rp[1]-0.5)*40, y, xv + x_dir*5*rp[2], yv-7*rp[3], 0, a, 0);
+        emitParticle(w, ROCKFALL_P2, x+(rp[4]-0.5)*40, y, xv + x_dir*5*rp[5], yv-7*rp[6], 0, a, 0);
+        emitParticle(w, ROCKFALL_P2, x+(rp[7]-0.5)*40, y, xv + x_dir*5*rp[8], yv-7*rp[9], 0, a, 0);
     }
+    traceEnd("collideRockfall");
 }
 
 // Action function for an arcsurge collision (stored as fxn ptr in spellInfo)
-static void collideArcsurge(Sprite sp)
+static void collideArcsurge(World w, Sprite sp)
 {
     // Arcsurge does not react to collisions
 }
@@ -493,37 +638,40 @@ static void collideArcsurge(Sprite sp)
 /* PER FRAME UPDATES */
 
 // If a human sprite is ready to launch a casted spell, launch it
-static void launchSpell(Sprite sp)
+static void launchSpell(World w, int i)
 {
     // Set cooldown and launch the spell if sprite has finished its casting animation
+    Sprite sp = slotRecord(w, i);
     int spell = sp->spell;
-    if(sp->casting == spell_info[spell]->finish_time)
+    if(w->active.casting[i] == spell_info[spell]->finish_time)
     {
         sp->cooldowns[spell] = spell_info[spell]->cooldown;
-        spell_info[spell]->on_launch(sp);
+        w->spell_casts[spell]++;
+        spell_info[spell]->on_launch(w, sp);
     }
 }
 
 // Human sprites launch any spells they are ready to launch
-void launchSpells()
+void launchSpells(World w)
 {
-    // Iterate over active sprites
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
+    // Iterate over active sprites (spells launched this frame are appended, and can't launch anything)
+    int count = w->active.count;
+    for(int i = 0; i < count; i++)
     {
-        if(cursor->sp->meta->type == HUMANOID) launchSpell(cursor->sp);
+        if(w->active.type[i] == HUMANOID) launchSpell(w, i);
     }
 }
 
 // Check if sprites are in the vicinity of one another with easy bounding circle check
-static bool boundingCircleCheck(Sprite sp, Sprite other)
+static bool boundingCircleCheck(World w, int i, int j)
 {
     // Get x and y distances of sprites from each other
-    double x_dist = xCenter(sp) - xCenter(other);
-    double y_dist = yCenter(sp) - yCenter(other);
+    double x_dist = xCenter(w, i) - xCenter(w, j);
+    double y_dist = yCenter(w, i) - yCenter(w, j);
 
     // Compare the distance squared with the sum of the radii squared
     double distance_squared = x_dist * x_dist + y_dist * y_dist;
-    double rad_sum = sp->meta->radius + other->meta->radius;
+    double rad_sum = sprite_info[w->active.id[i]]->radius + sprite_info[w->active.id[j]]->radius;
 
     // If they're close enough, return true so we can do bounding box check
     if((rad_sum * rad_sum) <= distance_squared) return false;
@@ -531,21 +679,23 @@ static bool boundingCircleCheck(Sprite sp, Sprite other)
 }
 
 // Precisely check if sprites are touching by comparing their arrays of bounding boxes
-static bool boundingBoxesCheck(Sprite sp, Sprite other)
+static bool boundingBoxesCheck(World w, int i, int j)
 {
-    // Nested for loop to compare each box of sp with each box of other
-    SDL_Rect* b1 = getBounds(sp);
-    SDL_Rect* b2 = getBounds(other);
-    for(int i = 0; i < sp->meta->num_bounds; i++)
+    // Nested for loop to compare each box of sprite i with each box of sprite j
+    SDL_Rect* b1 = getBounds(w, i);
+    SDL_Rect* b2 = getBounds(w, j);
+    int n1 = sprite_info[w->active.id[i]]->num_bounds;
+    int n2 = sprite_info[w->active.id[j]]->num_bounds;
+    for(int a = 0; a < n1; a++)
     {
-        int x1 = b1[i].x + sp->x_pos;
-        int y1 = b1[i].y + sp->y_pos;
-        for(int j = 0; j < other->meta->num_bounds; j++)
+        int x1 = b1[a].x + w->active.x_pos[i];
+        int y1 = b1[a].y + w->active.y_pos[i];
+        for(int b = 0; b < n2; b++)
         {
             // AABB
-            int x2 = b2[j].x + other->x_pos;
-            int y2 = b2[j].y + other->y_pos;
-            if((x1 < x2 + b2[j].w && x1 + b1[i].w > x2) && (y1 < y2 + b2[j].h && y1 + b1[i].h > y2))
+            int x2 = b2[b].x + w->active.x_pos[j];
+            int y2 = b2[b].y + w->active.y_pos[j];
+            if((x1 < x2 + b2[b].w && x1 + b1[a].w > x2) && (y1 < y2 + b2[b].h && y1 + b1[a].h > y2))
             {
                 return true;
             }
@@ -554,395 +704,376 @@ static bool boundingBoxesCheck(Sprite sp, Sprite other)
     return false;
 }
 
-// Process a collision between two sprites
-static void applyCollision(Sprite sp, Sprite other)
+// Process a collision between two sprites (sprite i is hit by sprite j)
+static void applyCollision(World w, int i, int j)
 {
     // All sprites take damage from collisions
-    sp->hp = fmax(0, sp->hp - other->meta->power);
+    int hp = w->active.hp[i];
+    w->active.hp[i] = fmax(0, hp - sprite_info[w->active.id[j]]->power);
 
     // Humans are knocked back by collisions, and spellcasts are cancelled
-    if(sp->meta->type == HUMANOID)
+    if(w->active.type[i] == HUMANOID)
     {
+        // Count the hit towards the spell's statistics (humans are only ever hit by spells)
+        w->spell_hits[w->active.id[j]]++;
+        w->spell_damage[w->active.id[j]] += hp - w->active.hp[i];
+
         // Get which direction the collision is coming from
-        int direction = convert(xCenter(other) >= xCenter(sp));
+        int direction = convert(xCenter(w, j) >= xCenter(w, i));
 
         // Special case: Arcsurge always hits target in the direction that it is cast
-        if(other->meta->id == ARCSURGE) direction = convert(!other->direction);
+        if(w->active.id[j] == ARCSURGE) direction = convert(!w->active.direction[j]);
 
         // Apply collision
-        sp->colliding = 20;
-        sp->x_vel = -5 * direction;
-        sp->y_vel = -3;
-        sp->casting = 0;
+        w->active.colliding[i] = 20;
+        w->active.x_vel[i] = -5 * direction;
+        w->active.y_vel[i] = -3;
+        w->active.casting[i] = 0;
     }
 
     // Spells have specialized collision handlers
-    if(sp->meta->type == SPELL) spell_info[sp->meta->id]->on_collide(sp);
+    if(w->active.type[i] == SPELL) spell_info[w->active.id[i]]->on_collide(w, slotRecord(w, i));
 }
 
-// Detect and handle all collisions between sprites in this frame
-void spriteCollisions()
+// Check a candidate pair of colliders found by the broadphase, and handle the collision if they touch
+static void collidePair(World w, int a, int b)
 {
-    // Iterate over all active sprites
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
-    {
-        // Colliding sprites, spawning sprites, and particles don't interact
-        Sprite sp = cursor->sp;
-        if(sp->meta->type == PARTICLE || sp->colliding || sp->spawning) continue;
+    // Either sprite may have started colliding earlier this frame, and then no longer interacts
+    int i = w->colliders[a];
+    int j = w->colliders[b];
+    if(w->active.colliding[i] || w->active.colliding[j]) return;
 
-        // Otherwise, need to check for a collision against every other sprite
-        for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
-        {
-            // Colliding sprites, spawning sprites, and particles don't interact
-            Sprite other = cursor->sp;
-            if(other->meta->type == PARTICLE || other->colliding || other->spawning) continue;
+    // Humans don't collide with other humans
+    if(w->active.type[i] == HUMANOID && w->active.type[j] == HUMANOID) return;
+    w->pairs_tested++;
 
-            // Sprites don't collide with themselves and humans don't collide with other humans
-            if(sp == other || (other->meta->type == HUMANOID && sp->meta->type == HUMANOID)) continue;
+    // Bounding circle check – if two sprites aren't even close to each other, don't bother
+    if(!boundingCircleCheck(w, i, j)) return;
 
-            // Bounding circle check – if two sprites aren't even close to each other, don't bother
-            if(!boundingCircleCheck(sp, other)) continue;
+    // If circle check passes, do more precise bounding box array check
+    if(!boundingBoxesCheck(w, i, j)) return;
 
-            // If circle check passes, do more precise bounding box array check
-            if(!boundingBoxesCheck(sp, other)) continue;
+    // Apply the effects of the collision to both sprites
+    w->pairs_hit++;
+    applyCollision(w, i, j);
+    applyCollision(w, j, i);
+}
 
-            // Apply the effects of the collision to both sprites
-            applyCollision(sp, other);
-            applyCollision(other, sp);
-        }
+// Detect and handle all collisions between sprites in this frame
+void spriteCollisions(World w)
+{
+    // Gather the bounding circles of all sprites that can collide
+    // (colliding sprites and spawning sprites don't interact)
+    int n = 0;
+    for(int i = 0; i < w->active.count; i++)
+    {
+        if(w->active.colliding[i] || w->active.spawning[i]) continue;
+        w->colliders[n] = i;
+        w->collider_key[n] = w->active.record[i];
+        w->collider_x[n] = xCenter(w, i);
+        w->collider_y[n] = yCenter(w, i);
+        w->collider_r[n] = sprite_info[w->active.id[i]]->radius;
+        n++;
     }
+    w->pairs_possible += (long long) n * (n - 1) / 2;
+
+    // Let the broadphase find the pairs which are close enough to check precisely
+    findPairs(w, n, w->collider_key, w->collider_x, w->collider_y, w->collider_r, collidePair);
 }
 
 // Detect and handle terrain collisions in this frame for a sprite
-static void terrainCollision(Sprite sp, int* platforms, int* walls)
+static void terrainCollision(World w, int i, int* platforms, int* walls)
 {
     // Precomputation
-    int touching_wall = touchingWall(sp, walls);
-    int on_platform = onPlatform(sp, platforms);
-    int on_ground = onGround(sp, platforms);
+    int touching_wall = touchingWall(w, i, walls);
+    int on_platform = onPlatform(w, i, platforms);
+    int on_ground = onGround(w, i, platforms);
 
     // Different sprite types handle terrain collisions differently
-    switch(sp->meta->type)
+    switch(w->active.type[i])
     {
         case HUMANOID:
             // Humans are stopped by walls
             if(touching_wall != -1)
             {
-                sp->x_vel = 0;
-                sp->x_pos = touching_wall;
+                w->active.x_vel[i] = 0;
+                w->active.x_pos[i] = touching_wall;
             }
 
             // (Falling) humans are stopped by platforms
             if(on_platform != -1)
             {
-                sp->y_vel = 0;
-                sp->y_pos = on_platform;
+                w->active.y_vel[i] = 0;
+                w->active.y_pos[i] = on_platform;
             }
             break;
 
         case SPELL:
             // Spells collide with ground and walls
-            if(!sp->colliding && !sp->spawning && (on_ground || touching_wall != -1))
+            if(!w->active.colliding[i] && !w->active.spawning[i] && (on_ground || touching_wall != -1))
             {
                 // Spells have specialized collision handlers
-                spell_info[sp->meta->id]->on_collide(sp);
-            }
-            break;
-
-        case PARTICLE:
-            // Particles collide with ground and walls
-            if(!sp->colliding && (on_ground || touching_wall != -1))
-            {
-                // Particles die immediately on terrain contact
-                sp->hp = 0;
-                sp->colliding = 2;
+                spell_info[w->active.id[i]]->on_collide(w, slotRecord(w, i));
             }
             break;
     }
 }
 
 // Check for and handle terrain collisions for all active sprites
-void terrainCollisions(int* platforms, int* walls)
+void terrainCollisions(World w, int* platforms, int* walls)
 {
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
+    for(int i = 0; i < w->active.count; i++)
     {
-        terrainCollision(cursor->sp, platforms, walls);
+        terrainCollision(w, i, platforms, walls);
     }
 }
 
 // Update which animation action the sprite is currently in based on its state
-static void updateAction(Sprite sp)
+static void updateAction(World w, int i)
 {
-    double xv = sp->x_vel;
-    double yv = sp->y_vel;
-    int type = sp->meta->type;
-    if(type == HUMANOID && sp->hp == 0)             setAction(sp, DIE);
-    else if(sp->spawning)                           setAction(sp, SPAWN);
-    else if(sp->colliding)                          setAction(sp, COLLIDE);
-    else if(sp->casting)                            setAction(sp, spell_info[sp->spell]->action);
-    else if(type == HUMANOID && xv == 0 && yv == 0) setAction(sp, IDLE);
-    else if(type == HUMANOID && yv != 0)            setAction(sp, JUMP);
-    else                                            setAction(sp, MOVE);
+    double xv = w->active.x_vel[i];
+    double yv = w->active.y_vel[i];
+    int type = w->active.type[i];
+    if(type == HUMANOID && w->active.hp[i] == 0)       setAction(w, i, DIE);
+    else if(w->active.spawning[i])                     setAction(w, i, SPAWN);
+    else if(w->active.colliding[i])                    setAction(w, i, COLLIDE);
+    else if(w->active.casting[i])                      setAction(w, i, spell_info[slotRecord(w, i)->spell]->action);
+    else if(type == HUMANOID && xv == 0 && yv == 0) setAction(w, i, IDLE);
+    else if(type == HUMANOID && yv != 0)            setAction(w, i, JUMP);
+    else                                            setAction(w, i, MOVE);
 }
 
 // Update the animation frame (picture that gets drawn) for a sprite
-static void updateAnimationFrame(Sprite sp)
+static void updateAnimationFrame(World w, int i)
 {
     // Update which action the sprite is currently taking based on its state
-    updateAction(sp);
+    updateAction(w, i);
 
-    // Sprite proceeds through animation frames faster during certain actions
-    int a = sp->action;
-    double increment = ANIMATION_SPEED * 0.1;
-    if(a == MOVE && sp->meta->id == GUY) increment *= 2;
-    if(a == JUMP || a == COLLIDE || a == SPAWN || sp->meta->id == ARCSURGE) increment *= 1.5;
-    if(a >= CAST_FIREBALL) increment *= 2.5;
-    sp->frame += increment;
+    // Look up the animation for the action the sprite is now taking
+    const struct animation* anim = &sprite_info[w->active.id[i]]->anims[w->active.action[i]];
+    w->active.frame[i] += anim->rate;
 
     // If the sprite's action has just changed, reset to first animation frame of that action
-    if(sp->action_change) sp->frame = sp->meta->frame_sections[a];
-    sp->action_change = false;
+    if(w->active.action_change[i]) w->active.frame[i] = anim->first;
+    w->active.action_change[i] = false;
 
     // Wraparound to first animation frame of an action if we reach the last frame for that action
-    if(sp->frame >= sp->meta->frame_sections[a+1])
+    if(w->active.frame[i] >= anim->end)
     {
-        sp->frame = sp->meta->frame_sections[a];
+        w->active.frame[i] = anim->first;
     }
 }
 
 // Update the animation frame which is drawn for all active sprites
-void updateAnimationFrames()
+void updateAnimationFrames(World w)
 {
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
+    for(int i = 0; i < w->active.count; i++)
     {
-        updateAnimationFrame(cursor->sp);
+        updateAnimationFrame(w, i);
     }
 }
 
 // Calculate physics and update position/velocity/orientation for a sprite
-static void moveSprite(Sprite sp)
+static void moveSprite(World w, int i)
 {
     // Update the sprite's position
-    sp->x_pos += sp->x_vel;
-    sp->y_pos += sp->y_vel;
+    w->active.x_pos[i] += w->active.x_vel[i];
+    w->active.y_pos[i] += w->active.y_vel[i];
 
     // Update the sprite's velocity and orientation (the physics are different for different spells)
-    switch(sp->meta->id)
+    double* xv = &w->active.x_vel[i];
+    double* yv = &w->active.y_vel[i];
+    switch(w->active.id[i])
     {
         case GUY:
             // Update x velocity (friction / air resistance)
-            if(fabs(sp->x_vel) <= 0.3) sp->x_vel = 0;
-            else                       sp->x_vel += convert(sp->x_vel < 0.0f) * 0.15;
+            if(fabs(*xv) <= 0.3) *xv = 0;
+            else                 *xv += convert(*xv < 0.0f) * 0.15;
 
             // Update y velocity (terminal velocity of 50)
-            sp->y_vel = fmin(sp->y_vel + 0.5, 50);
+            *yv = fmin(*yv + 0.5, 50);
             break;
 
         case FIREBALL:
             // Fireball accelerates over time and spawns a particle trail
-            if(!sp->colliding)
+            if(!w->active.colliding[i])
             {
-                sp->x_vel += convert(sp->x_vel > 0) * 0.15;
+                *xv += convert(*xv > 0) * 0.15;
 
-                if(get_rand() <= fabs(sp->x_vel) * 0.05)
+                if(get_rand(&w->rng, RNG_COSMETIC) <= fabs(*xv) * 0.05 * getParticleBudget(w))
                 {
-                    double x = sp->x_pos + (!sp->direction * 15);
-                    double y = sp->y_pos + get_rand() * 8;
-                    double xv = convert(sp->direction) * fmin(fabs(sp->x_vel - convert(sp->direction) * 0.7), 5);
-                    xv += get_rand() - 0.5;
-                    double yv = get_rand() - 0.5;
-                    spawnSprite(FIREBALL_P1, x, y, xv, yv, RIGHT, 0, 0, 10);
+                    bool dir = w->active.direction[i];
+                    double x = w->active.x_pos[i] + (!dir * 15);
+                    double y = w->active.y_pos[i] + get_rand(&w->rng, RNG_COSMETIC) * 8;
+                    double p_xv = convert(dir) * fmin(fabs(*xv - convert(dir) * 0.7), 5);
+                    p_xv += get_rand(&w->rng, RNG_COSMETIC) - 0.5;
+                    double p_yv = get_rand(&w->rng, RNG_COSMETIC) - 0.5;
+                    emitParticle(w, FIREBALL_P1, x, y, p_xv, p_yv, RIGHT, 0, 10);
                 }
             }
 
             // Fireball faces in the direction of x-velocity (LEFT and RIGHT are in an enum so this works)
-            sp->direction = (sp->x_vel >= 0);
+            w->active.direction[i] = (*xv >= 0);
             break;
 
         case ICESHOCK:
-        case ICESHOCK_P1:
             // Iceshock is affected by gravity and air resistance
-            if(!sp->colliding) sp->y_vel += 0.3;
-            sp->x_vel += convert(sp->x_vel < 0.0f) * 0.03;
+            if(!w->active.colliding[i]) *yv += 0.3;
+            *xv += convert(*xv < 0.0f) * 0.03;
 
             // Iceshock faces in the direction of xy-velocity
-            sp->direction = (sp->x_vel >= 0);
-            sp->angle = (int) (57.296 * atan(sp->y_vel / sp->x_vel));
+            w->active.direction[i] = (*xv >= 0);
+            w->active.angle[i] = (int) (57.296 * atan(*yv / *xv));
             break;
 
         case ROCKFALL:
             // Rockfall falls quickly after it's done spawning
-            if(!sp->colliding && !sp->spawning) sp->y_vel += 1.2;
+            if(!w->active.colliding[i] && !w->active.spawning[i]) *yv += 1.2;
 
             // Rockfall rotates slowly as it falls
-            sp->direction = (sp->x_vel >= 0);
-            sp->angle += 2;
-            if(sp->colliding) sp->angle = 0;
-            break;
-
-        case ROCKFALL_P1:
-        case ROCKFALL_P2:
-            // Rockfall particles rotate and fall
-            sp->direction = (sp->x_vel >= 0);
-            sp->angle += 5;
-            sp->y_vel += 0.3;
+            w->active.direction[i] = (*xv >= 0);
+            w->active.angle[i] += 2;
+            if(w->active.colliding[i]) w->active.angle[i] = 0;
             break;
 
         case DARKEDGE:
             // Darkedge accelerates over time and spawns a particle trail
-            if(!sp->colliding && !sp->spawning)
+            if(!w->active.colliding[i] && !w->active.spawning[i])
             {
-                sp->x_vel += convert(sp->x_vel > 0) * 0.4;
-                sp->y_vel += 0.1;
+                *xv += convert(*xv > 0) * 0.4;
+                *yv += 0.1;
 
-                if(get_rand() <= fabs(sp->x_vel) * 0.1)
+                if(get_rand(&w->rng, RNG_COSMETIC) <= fabs(*xv) * 0.1 * getParticleBudget(w))
                 {
-                    double x = sp->x_pos + (!sp->direction * 60);
-                    double y = sp->y_pos + (get_rand() - 0.2) * 20;
-                    double xv = (0.5 * sp->x_vel) + (get_rand() - 0.5) / 2;
-                    double yv = (0.5 * sp->y_vel) + (get_rand() - 0.5) / 2;
-                    spawnSprite(DARKEDGE_P1, x, y, xv, yv, RIGHT, 0, 0, 10);
+                    double x = w->active.x_pos[i] + (!w->active.direction[i] * 60);
+                    double y = w->active.y_pos[i] + (get_rand(&w->rng, RNG_COSMETIC) - 0.2) * 20;
+                    double p_xv = (0.5 * *xv) + (get_rand(&w->rng, RNG_COSMETIC) - 0.5) / 2;
+                    double p_yv = (0.5 * *yv) + (get_rand(&w->rng, RNG_COSMETIC) - 0.5) / 2;
+                    emitParticle(w, DARKEDGE_P1, x, y, p_xv, p_yv, RIGHT, 0, 10);
                 }
             }
 
             // Darkedge faces in the direction of xy-velocity
-            sp->direction = (sp->x_vel >= 0);
-            sp->angle = (int) (57.296 * atan(sp->y_vel / sp->x_vel));
-            break;
-
-        case DARKEDGE_P1:
-            // Darkedge/Fireball particles wobble around randomly
-            if(get_rand() <= 0.05)
-            {
-                sp->x_vel = (get_rand() - 0.5) / 2;
-                sp->y_vel = (get_rand() - 0.5) / 2;
-            }
+            w->active.direction[i] = (*xv >= 0);
+            w->active.angle[i] = (int) (57.296 * atan(*yv / *xv));
             break;
 
         case ARCSURGE:
-        case FIREBALL_P1:
             // The electric shock of Arcsurge doesn't move
             break;
-
-        case ARCSURGE_P1:
-            // Arcsurge particles randomly change direction
-            if(get_rand() <= 0.2)
-            {
-                double tmp = fabs(sp->x_vel) * convert(get_rand() - 0.5 > 0);
-                sp->x_vel = sp->y_vel;
-                sp->y_vel = tmp;
-                sp->x_vel += (get_rand() - 0.5)*3;
-            }
-
-            // Arcsurge particles slow down heavily but do not fall
-            sp->x_vel += convert(sp->x_vel < 0) * 0.1;
-            sp->y_vel += convert(sp->y_vel < 0) * 0.1;
-            break;
     }
 }
 
 // Calculate physics and update position and orientation for all active sprites
-void moveSprites()
+void moveSprites(World w)
 {
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
-    {
-        moveSprite(cursor->sp);
-    }
-}
-
-// Advance timed variables for this sprite
-static void advanceTime(Sprite sp)
-{
-    // Update casting time
-    if(sp->casting) sp->casting--;
-
-    // Update spawning animation duration
-    if(sp->spawning) sp->spawning--;
+    // Remember where every sprite was, so rendering can interpolate
+    for(int i = 0; i < w->active.count; i++) w->active.x_prev[i] = w->active.x_pos[i];
+    for(int i = 0; i < w->active.count; i++) w->active.y_prev[i] = w->active.y_pos[i];
 
-    // Update cooldowns
-    if(sp->meta->type == HUMANOID)
+    for(int i = 0; i < w->active.count; i++)
     {
-        for(int i = 0; i < NUM_SPELLS; i++)
-        {
-            if(sp->cooldowns[i]) sp->cooldowns[i]--;
-        }
+        moveSprite(w, i);
     }
-
-    // Update collision time
-    if(sp->colliding) sp->colliding--;
-
-    // Update sprite lifetime
-    if(sp->lifetime) sp->lifetime--;
 }
 
 // Advance timed sprite variables which update every frame
-void advanceTimers()
+void advanceTimers(World w)
 {
-    // Iterate over active sprites
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
+    // Each timer is swept over the whole store separately
+    int count = w->active.count;
+    for(int i = 0; i < count; i++) if(w->active.casting[i]) w->active.casting[i]--;
+    for(int i = 0; i < count; i++) if(w->active.spawning[i]) w->active.spawning[i]--;
+    for(int i = 0; i < count; i++) if(w->active.colliding[i]) w->active.colliding[i]--;
+    for(int i = 0; i < count; i++) if(w->active.lifetime[i]) w->active.lifetime[i]--;
+
+    // Only the guys have cooldowns to update
+    for(int g = 0; g < 2; g++)
     {
-        advanceTime(cursor->sp);
+        if(w->guys[g] == NO_RECORD) continue;
+        for(int s = 0; s < NUM_SPELLS; s++)
+        {
+            if(guyRecord(w, g)->cooldowns[s]) guyRecord(w, g)->cooldowns[s]--;
+        }
     }
 }
 
-// Render a sprite's bounding boxes on top of the sprite (only in debug)
-static void renderBounds(Sprite sp)
+// Render a sprite's bounding boxes on top of the sprite, drawn at (x, y) (only in debug)
+static void renderBounds(int id, bool direction, int x, int y)
 {
     // For each box, render 4 lines to create the rectangle
-    SDL_Rect* bounds = getBounds(sp);
-    for(int i = 0; i < sp->meta->num_bounds; i++)
+    SDL_Rect* bounds = getBoundsFacing(id, direction);
+    for(int b = 0; b < sprite_info[id]->num_bounds; b++)
     {
         // Line 1
-        SDL_Rect box = bounds[i];
+        SDL_Rect box = bounds[b];
         SDL_Rect clip = {739, 77, box.w, 1};
-        SDL_Rect renderQuad = {(int)sp->x_pos + box.x, (int)sp->y_pos + box.y, box.w, 1};
-        SDL_RenderCopyEx(renderer, sprite_sheet, &clip, &renderQuad, 0, NULL, SDL_FLIP_NONE);
+        SDL_Rect renderQuad = {x + box.x, y + box.y, box.w, 1};
+        batchCopy(&clip, &renderQuad, 0, SDL_FLIP_NONE);
 
         // Line 2
-        renderQuad = (SDL_Rect) {(int)sp->x_pos + box.x, (int)sp->y_pos + box.y + box.h, box.w, 1};
-        SDL_RenderCopyEx(renderer, sprite_sheet, &clip, &renderQuad, 0, NULL, SDL_FLIP_NONE);
+        renderQuad = (SDL_Rect) {x + box.x, y + box.y + box.h, box.w, 1};
+        batchCopy(&clip, &renderQuad, 0, SDL_FLIP_NONE);
 
         // Line 3
         clip = (SDL_Rect) {739, 77, 1, box.h};
-        renderQuad = (SDL_Rect) {(int)sp->x_pos+ box.x, (int)sp->y_pos + box.y, 1, box.h};
-        SDL_RenderCopyEx(renderer, sprite_sheet, &clip, &renderQuad, 0, NULL, SDL_FLIP_NONE);
+        renderQuad = (SDL_Rect) {x + box.x, y + box.y, 1, box.h};
+        batchCopy(&clip, &renderQuad, 0, SDL_FLIP_NONE);
 
         // Line 4
-        renderQuad = (SDL_Rect) {(int)sp->x_pos + box.x + box.w, (int)sp->y_pos + box.y, 1, box.h};
-        SDL_RenderCopyEx(renderer, sprite_sheet, &clip, &renderQuad, 0, NULL, SDL_FLIP_NONE);
+        renderQuad = (SDL_Rect) {x + box.x + box.w, y + box.y, 1, box.h};
+        batchCopy(&clip, &renderQuad, 0, SDL_FLIP_NONE);
     }
 }
 
-// Render a sprite from the sprite sheet to the screen
-static void renderSprite(Sprite sp)
+// Render a captured sprite from the sprite sheet to the screen, alpha of the way from its previous to its current position
+static void renderSprite(const struct sprite_view* view, int i, double alpha)
 {
     // Make sure sprite is facing the proper direction
     SDL_RendererFlip flipType = SDL_FLIP_NONE;
-    if (sp->direction == LEFT) flipType = SDL_FLIP_HORIZONTAL;
+    if (view->direction[i] == LEFT) flipType = SDL_FLIP_HORIZONTAL;
 
     // Grab the sprite at it's current frame from the spritesheet
-    SDL_Rect clip = {sp->meta->width * (int) sp->frame, sp->meta->sheet_position, sp->meta->width, sp->meta->height};
+    SpriteInfo meta = sprite_info[view->id[i]];
+    SDL_Rect clip = meta->clips[(int) view->frame[i]];
 
-    // Draw the sprite at its current x and y position
-    SDL_Rect renderQuad = {(int)sp->x_pos, (int)sp->y_pos, sp->meta->width, sp->meta->height};
-    SDL_RenderCopyEx(renderer, sprite_sheet, &clip, &renderQuad, sp->angle, NULL, flipType);
+    // Draw the sprite between its previous and current x and y position
+    int x = (int) lerp(view->x_prev[i], view->x_pos[i], alpha);
+    int y = (int) lerp(view->y_prev[i], view->y_pos[i], alpha);
+    SDL_Rect renderQuad = {x, y, meta->width, meta->height};
+    batchCopy(&clip, &renderQuad, view->angle[i], flipType);
 
     // In debug mode, render bounding boxes and sprite positions
-    if(debug && sp->meta->type != PARTICLE)
+    if(debug)
     {
-        renderBounds(sp);
+        renderBounds(view->id[i], view->direction[i], x, y);
         clip = (SDL_Rect) {743, 81, 3, 3};
-        renderQuad = (SDL_Rect) {(int)sp->x_pos, (int)sp->y_pos, 3, 3};
-        SDL_RenderCopyEx(renderer, sprite_sheet, &clip, &renderQuad, 0, NULL, SDL_FLIP_NONE);
+        renderQuad = (SDL_Rect) {x, y, 3, 3};
+        batchCopy(&clip, &renderQuad, 0, SDL_FLIP_NONE);
     }
 }
 
-// Render all active sprites to the screen
-void renderSprites()
+// Capture everything needed to draw the active sprites
+void captureSprites(World w, struct sprite_view* view)
+{
+    int count = view->count = w->active.count;
+    for(int i = 0; i < count; i++) view->id[i] = w->active.id[i];
+    for(int i = 0; i < count; i++) view->x_prev[i] = w->active.x_prev[i];
+    for(int i = 0; i < count; i++) view->y_prev[i] = w->active.y_prev[i];
+    for(int i = 0; i < count; i++) view->x_pos[i] = w->active.x_pos[i];
+    for(int i = 0; i < count; i++) view->y_pos[i] = w->active.y_pos[i];
+    for(int i = 0; i < count; i++) view->direction[i] = w->active.direction[i];
+    for(int i = 0; i < count; i++) view->angle[i] = w->active.angle[i];
+    for(int i = 0; i < count; i++) view->frame[i] = w->active.frame[i];
+}
+
+// Render captured sprites to the screen
+void renderSprites(const struct sprite_view* view, double alpha)
 {
-    for(struct ele* cursor = active_sprites; cursor != NULL; cursor = cursor->next)
+    // Newest sprites are drawn first, so the guys end up on top
+    for(int i = view->count - 1; i >= 0; i--)
     {
-        renderSprite(cursor->sp);
+        renderSprite(view, i, alpha);
     }
 }
 
@@ -975,7 +1106,7 @@ static SDL_Rect* reflectBounds(SDL_Rect* rbounds, int num_bounds, int width)
 
 // Assign meta info fields for a spell
 static SpellInfo initSpell(int act, int cast, int finish, int cd,
-                           void (*launch)(Sprite), void (*collide)(Sprite))
+                           void (*launch)(World, Sprite), void (*collide)(World, Sprite))
 {
     SpellInfo this_spell = (SpellInfo) malloc(sizeof(struct spell_metainfo));
     this_spell->action = act;
@@ -988,9 +1119,43 @@ static SpellInfo initSpell(int act, int cast, int finish, int cd,
     return this_spell;
 }
 
+// Speed at which a sprite proceeds through the animation frames of an action
+static double animationRate(int id, int a)
+{
+    // Sprite proceeds through animation frames faster during certain actions
+    double rate = ANIMATION_SPEED * 0.1;
+    if(a == MOVE && id == GUY) rate *= 2;
+    if(a == JUMP || a == COLLIDE || a == SPAWN || id == ARCSURGE) rate *= 1.5;
+    if(a >= CAST_FIREBALL) rate *= 2.5;
+    return rate;
+}
+
+// Build the animation and clip tables for a sprite from its frame sections, which hold
+// the first animation frame of each action followed by the total number of frames
+static void buildAnimations(SpriteInfo meta, const int* fs, int num_sections)
+{
+    // One animation for each action
+    meta->num_actions = num_sections - 1;
+    meta->anims = malloc(sizeof(struct animation) * meta->num_actions);
+    for(int a = 0; a < meta->num_actions; a++)
+    {
+        meta->anims[a].first = fs[a];
+        meta->anims[a].end = fs[a+1];
+        meta->anims[a].rate = animationRate(meta->id, a);
+    }
+
+    // One clip for each animation frame, laid out in a row on the sprite sheet
+    int num_frames = fs[meta->num_actions];
+    meta->clips = malloc(sizeof(SDL_Rect) * num_frames);
+    for(int f = 0; f < num_frames; f++)
+    {
+        meta->clips[f] = (SDL_Rect) {meta->width * f, meta->sheet_position, meta->width, meta->height};
+    }
+}
+
 // Assign meta info fields for a sprite
 static SpriteInfo initSprite(int id, int type, int power, int hp, int width, int height,
-                             int sheet_pos, int* fs, int num_bounds, SDL_Rect* bounds)
+                             int sheet_pos, const int* fs, int num_sections, int num_bounds, SDL_Rect* bounds)
 {
     SpriteInfo this_sprite = (SpriteInfo) malloc(sizeof(struct sprite_metainfo));
     this_sprite->id = id;
@@ -1004,7 +1169,7 @@ static SpriteInfo initSprite(int id, int type, int power, int hp, int width, int
     this_sprite->rbounds = bounds;
     this_sprite->lbounds = reflectBounds(bounds, num_bounds, width);
     this_sprite->sheet_position = sheet_pos;
-    this_sprite->frame_sections = fs;
+    buildAnimations(this_sprite, fs, num_sections);
     return this_sprite;
 }
 
@@ -1014,185 +1179,117 @@ void loadSpriteInfo()
     // Load the spritesheet texture into memory
     sprite_sheet = loadTexture("art/Spritesheet.bmp");
 
-    // Make space for meta info structs
-    sprite_info = (SpriteInfo*) malloc(sizeof(SpriteInfo) * NUM_SPRITES);
+    // Make space for meta info structs (particle meta info is kept separately, see particle.c)
+    sprite_info = (SpriteInfo*) calloc(NUM_SPRITES, sizeof(SpriteInfo));
     spell_info = (SpellInfo*) malloc(sizeof(SpellInfo) * NUM_SPELLS);
 
     // HUMANS
 
     // Sprite metadata: Guy
     int numBounds = 2;
-    int* fs = (int*) malloc(sizeof(int) * 12);
-    memcpy(fs, (int[]) {0, 0, 4, 5, 10, 14, 22, 30, 40, 51, 64, 69}, sizeof(int) * 12);
+    int fs[12] = {0, 0, 4, 5, 10, 14, 22, 30, 40, 51, 64, 69};
     SDL_Rect* bounds = malloc(sizeof(SDL_Rect) * numBounds);
     bounds[0] = (SDL_Rect) {9, 5, 15, 14};
     bounds[1] = (SDL_Rect) {10, 23, 10, 35};
-    sprite_info[GUY] = initSprite(GUY, HUMANOID, 10, 100, 28, 58, 0, fs, numBounds, bounds);
+    sprite_info[GUY] = initSprite(GUY, HUMANOID, 10, 100, 28, 58, 0, fs, 12, numBounds, bounds);
 
     // SPELLS
 
     // Sprite/Spell metadata: Fireball
     numBounds = 1;
-    fs = (int*) malloc(sizeof(int) * 4);
     memcpy(fs, (int[]) {0, 0, 2, 5}, sizeof(int) * 4);
     bounds = malloc(sizeof(SDL_Rect) * numBounds);
     bounds[0] = (SDL_Rect) {6, 2, 12, 6};
     spell_info[FIREBALL] = initSpell(CAST_FIREBALL, 32, 8, 120, launchFireball, collideGeneric);
-    sprite_info[FIREBALL] = initSprite(FIREBALL, SPELL, 15, 1, 23, 10, 60, fs, numBounds, bounds);
+    sprite_info[FIREBALL] = initSprite(FIREBALL, SPELL, 15, 1, 23, 10, 60, fs, 4, numBounds, bounds);
 
     // Sprite/Spell metadata: Iceshock
     numBounds = 1;
-    fs = (int*) malloc(sizeof(int) * 4);
     memcpy(fs, (int[]) {0, 0, 2, 5}, sizeof(int) * 4);
     bounds = malloc(sizeof(SDL_Rect) * numBounds);
     bounds[0] = (SDL_Rect) {6, 1, 13, 7};
     spell_info[ICESHOCK] = initSpell(CAST_ICESHOCK, 32, 8, 240, launchIceshock, collideGeneric);
-    sprite_info[ICESHOCK] = initSprite(ICESHOCK, SPELL, 20, 1, 23, 10, 70, fs, numBounds, bounds);
+    sprite_info[ICESHOCK] = initSprite(ICESHOCK, SPELL, 20, 1, 23, 10, 70, fs, 4, numBounds, bounds);
 
     // Sprite/Spell metadata: Rockfall
     numBounds = 3;
-    fs = (int*) malloc(sizeof(int) * 4);
     memcpy(fs, (int[]) {0, 3, 4, 7}, sizeof(int) * 4);
     bounds = malloc(sizeof(SDL_Rect) * numBounds);
     bounds[0] = (SDL_Rect) {40, 5, 20, 90};
     bounds[1] = (SDL_Rect) {20, 20, 60, 60};
     bounds[2] = (SDL_Rect) {5, 40, 90, 20};
     spell_info[ROCKFALL] = initSpell(CAST_ROCKFALL, 40, 40, 420, launchRockfall, collideRockfall);
-    sprite_info[ROCKFALL] = initSprite(ROCKFALL, SPELL, 30, 1, 100, 100, 85, fs, numBounds, bounds);
+    sprite_info[ROCKFALL] = initSprite(ROCKFALL, SPELL, 30, 1, 100, 100, 85, fs, 4, numBounds, bounds);
 
     // Sprite/Spell metadata: Darkedge
     numBounds = 2;
-    fs = (int*) malloc(sizeof(int) * 4);
     memcpy(fs, (int[]) {0, 5, 8, 11}, sizeof(int) * 4);
     bounds = malloc(sizeof(SDL_Rect) * numBounds);
     bounds[0] = (SDL_Rect) {5, 8, 25, 10};
     bounds[1] = (SDL_Rect) {30, 15, 25, 10};
     spell_info[DARKEDGE] = initSpell(CAST_DARKEDGE, 44, 24, 420, launchDarkedge, collideGeneric);
-    sprite_info[DARKEDGE] = initSprite(DARKEDGE, SPELL, 25, 1, 60, 30, 215, fs, numBounds, bounds);
+    sprite_info[DARKEDGE] = initSprite(DARKEDGE, SPELL, 25, 1, 60, 30, 215, fs, 4, numBounds, bounds);
 
     // Sprite/Spell metadata: Arcsurge
     numBounds = 1;
-    fs = (int*) malloc(sizeof(int) * 4);
     memcpy(fs, (int[]) {0, 0, 3, 3}, sizeof(int) * 4);
     bounds = malloc(sizeof(SDL_Rect) * numBounds);
     bounds[0] = (SDL_Rect) {5, 20, 92, 20};
     spell_info[ARCSURGE] = initSpell(CAST_ARCSURGE, 52, 40, 600, launchArcsurge, collideArcsurge);
-    sprite_info[ARCSURGE] = initSprite(ARCSURGE, SPELL, 35, 1, 120, 60, 250, fs, numBounds, bounds);
-
-    // PARTICLES
-
-    numBounds = 0;
-    bounds = NULL;
-
-    // Sprite metadata: Fireball Particle 1
-    fs = (int*) malloc(sizeof(int) * 4);
-    memcpy(fs, (int[]) {0, 0, 2, 2}, sizeof(int) * 4);
-    sprite_info[FIREBALL_P1] = initSprite(FIREBALL_P1, PARTICLE, 0, 1, 5, 5, 315, fs, numBounds, bounds);
-
-    // Sprite metadata: Iceshock Particle 1
-    fs = (int*) malloc(sizeof(int) * 4);
-    memcpy(fs, (int[]) {0, 0, 2, 2}, sizeof(int) * 4);
-    sprite_info[ICESHOCK_P1] = initSprite(ICESHOCK_P1, PARTICLE, 0, 1, 5, 5, 80, fs, numBounds, bounds);
-
-    // Sprite metadata: Rockfall Particle 1
-    fs = (int*) malloc(sizeof(int) * 4);
-    memcpy(fs, (int[]) {0, 0, 1, 1}, sizeof(int) * 4);
-    sprite_info[ROCKFALL_P1] = initSprite(ROCKFALL_P1, PARTICLE, 0, 1, 25, 25, 185, fs, numBounds, bounds);
-
-    // Sprite metadata: Rockfall Particle 2
-    fs = (int*) malloc(sizeof(int) * 4);
-    memcpy(fs, (int[]) {0, 0, 2, 2}, sizeof(int) * 4);
-    sprite_info[ROCKFALL_P2] = initSprite(ROCKFALL_P2, PARTICLE, 0, 1, 5, 5, 210, fs, numBounds, bounds);
-
-    // Sprite metadata: Darkedge Particle 1
-    fs = (int*) malloc(sizeof(int) * 4);
-    memcpy(fs, (int[]) {0, 0, 2, 2}, sizeof(int) * 4);
-    sprite_info[DARKEDGE_P1] = initSprite(DARKEDGE_P1, PARTICLE, 0, 1, 5, 5, 245, fs, numBounds, bounds);
-
-    // Sprite metadata: Arcsurge Particle 1
-    fs = (int*) malloc(sizeof(int) * 4);
-    memcpy(fs, (int[]) {0, 0, 2, 2}, sizeof(int) * 4);
-    sprite_info[ARCSURGE_P1] = initSprite(ARCSURGE_P1, PARTICLE, 0, 1, 5, 5, 310, fs, numBounds, bounds);
+    sprite_info[ARCSURGE] = initSprite(ARCSURGE, SPELL, 35, 1, 120, 60, 250, fs, 4, numBounds, bounds);
 }
 
 /* DATA UNLOADING */
 
-// Free a sprite
-static void freeSprite(struct ele* e)
+// Free the sprite in a slot - its record goes back to the sprite pool, and the last
+// sprite in the store is moved into the slot to keep the store dense
+static void freeSprite(World w, int i)
 {
-    if(e->sp->meta->type == HUMANOID)
-    {
-        free(e->sp->cooldowns);
-    }
-    free(e->sp);
-    free(e);
+    releaseRecord(w, w->active.record[i]);
+    int last = --w->active.count;
+    if(i != last) moveSlot(w, i, last);
 }
 
 // Free any active sprites which have died
-int unloadSprites()
+int unloadSprites(World w)
 {
-    // Iterate over active sprites
-    struct ele* prev = NULL;
+    // Iterate over active sprites backwards, so that the sprite swapped into a freed slot
+    // has always been checked already
     int game_over = 0;
-    for(struct ele* cursor = active_sprites; cursor != NULL;)
+    for(int i = w->active.count - 1; i >= 0; i--)
     {
         // Check if the sprite is dead
-        if(isDead(cursor->sp))
+        if(!isDead(w, i)) continue;
+
+        if(w->active.id[i] == GUY)
         {
-            if(cursor->sp->meta->id == GUY)
+            // If the dead sprite is a Guy, just hide it and signal game over
+            if(w->active.record[i] == w->guys[0])
             {
-                // If the dead sprite is a Guy, just hide it and signal game over
-                if(cursor->sp == guys[0])
-                {
-                    hideGuy(0);
-                    game_over = 1;
-                }
-                else
-                {
-                    hideGuy(1);
-                    game_over = 2;
-                }
-
+                hideGuy(w, 0);
+                game_over = 1;
             }
             else
             {
-                // Otherwise remove the sprite from the active sprites and free it
-                if(prev == NULL)
-                {
-                    prev = cursor;
-                    cursor = cursor->next;
-                    freeSprite(prev);
-                    active_sprites = cursor;
-                    prev = NULL;
-                }
-                else
-                {
-                    struct ele* e = cursor;
-                    cursor = cursor->next;
-                    freeSprite(e);
-                    prev->next = cursor;
-                }
+                hideGuy(w, 1);
+                game_over = 2;
             }
         }
         else
         {
-            // If the sprite isn't dead, continue
-            prev = cursor;
-            cursor = cursor->next;
+            // Otherwise remove the sprite from the active sprites and free it
+            freeSprite(w, i);
         }
     }
     return game_over;
 }
 
 // Free all active sprites
-void freeActiveSprites()
+void freeActiveSprites(World w)
 {
-    for(struct ele* cursor = active_sprites; cursor != NULL;)
-    {
-        struct ele* e = cursor;
-        cursor = cursor->next;
-        freeSprite(e);
-    }
+    while(w->active.count) freeSprite(w, w->active.count - 1);
+    w->guys[0] = NO_RECORD;
+    w->guys[1] = NO_RECORD;
 }
 
 // Free all sprite and spell meta info
@@ -1201,12 +1298,12 @@ void freeSpriteInfo()
     // Free sprite metainfo
     for(int i = 0; i < NUM_SPRITES; i++)
     {
-        free(sprite_info[i]->frame_sections);
-        if(sprite_info[i]->type != PARTICLE)
-        {
-            free(sprite_info[i]->rbounds);
-            free(sprite_info[i]->lbounds);
-        }
+        // Particles have no sprite meta info (see particle.c)
+        if(!sprite_info[i]) continue;
+        free(sprite_info[i]->anims);
+        free(sprite_info[i]->clips);
+        free(sprite_info[i]->rbounds);
+        free(sprite_info[i]->lbounds);
         free(sprite_info[i]);
     }
     free(sprite_info);
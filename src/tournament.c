@@ -0,0 +1,232 @@
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/level.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/world.h"
+#include "../headers/tournament.h"
+
+// Struct for the result of one match
+struct match_result
+{
+    int winner;                 // which guy won (0 started on the left, 1 on the right), or -1 for a draw
+    int frames;                 // how many frames the match lasted
+    int level;                  // which level the match was played on
+    int winner_hp;              // health the winner had left
+    int casts[NUM_SPELLS];      // number of times each spell was cast
+    int hits[NUM_SPELLS];       // number of times each spell hit a guy
+    int damage[NUM_SPELLS];     // total damage each spell did to guys
+};
+
+// Struct for a worker thread, and the world it plays its matches in
+struct worker
+{
+    SDL_Thread* thread;         // thread the worker runs on (NULL for the main thread, or if it couldn't start)
+    World world;                // world reused for every match the worker plays
+    int matches;                // number of matches the worker played
+    long long frames;           // number of frames the worker simulated
+};
+
+// Names of the spells, for the summary
+static const char* spell_names[NUM_SPELLS] = { "Fireball", "Iceshock", "Rockfall", "Darkedge", "Arcsurge" };
+
+SDL_atomic_t next_match;                    // Number of the next match to be taken by a worker
+int tournament_matches = 0;                 // Number of matches in the tournament
+Uint64 tournament_seed = 0;                 // Seed every match's seed is derived from
+struct match_result* match_results = NULL;  // Result of every match, in match order
+
+/* PLAYING MATCHES */
+
+// Play one match to the end in a world, with the cpu controlling both guys
+static void playMatch(World w, int match, struct match_result* result)
+{
+    // Every match gets its own seed, and the levels take turns
+    resetWorld(w, tournament_seed + match);
+    int level = match % NUM_FOREGROUNDS;
+    switchLevel(w, level);
+    int* starts = getStartingPositions(level);
+    spawnSprite(w, GUY, starts[0], starts[1], 0, 0, RIGHT, 0, 0, 0);
+    spawnSprite(w, GUY, starts[2], starts[3], 0, 0, LEFT, 0, 0, 0);
+
+    // Play until a guy dies, or the match runs too long
+    int signal = 0;
+    while(!signal && w->frame < MATCH_FRAME_LIMIT)
+    {
+        takeCPUAction(w, 0);
+        takeCPUAction(w, 1);
+        signal = stepSimulation(w);
+        w->frame++;
+    }
+
+    // The guy who didn't die won (a dead guy is signalled as 1 or 2)
+    result->winner = signal ? signal == 1 : -1;
+    result->winner_hp = signal ? getHealth(w, result->winner) : 0;
+    result->frames = w->frame;
+    result->level = level;
+    for(int s = 0; s < NUM_SPELLS; s++)
+    {
+        getSpellStats(w, s, &result->casts[s], &result->hits[s], &result->damage[s]);
+    }
+}
+
+// Body of a worker thread: play the next unplayed match until there are none left
+static int workerThread(void* data)
+{
+    struct worker* worker = (struct worker*) data;
+    int match;
+    while((match = SDL_AtomicAdd(&next_match, 1)) < tournament_matches)
+    {
+        playMatch(worker->world, match, &match_results[match]);
+        worker->matches++;
+        worker->frames += match_results[match].frames;
+    }
+    return 0;
+}
+
+/* SUMMARY */
+
+// Compare match lengths, for sorting
+static int compareFrames(const void* a, const void* b)
+{
+    return *(const int*) a - *(const int*) b;
+}
+
+// Print a percentage of a total, or a dash if the total is zero
+static void printPercent(long long part, long long total)
+{
+    if(total) printf("%6.1f%%", 100.0 * part / total);
+    else      printf("%7s", "-");
+}
+
+// Add up the results of every match and print them
+static void printSummary(struct worker* workers, int num_threads, double seconds)
+{
+    // Tally wins, lengths, and spells
+    long long wins[2] = {0, 0}, draws = 0, level_wins[NUM_FOREGROUNDS][2] = {{0}}, level_matches[NUM_FOREGROUNDS] = {0};
+    long long total_frames = 0, winner_hp = 0;
+    long long casts[NUM_SPELLS] = {0}, hits[NUM_SPELLS] = {0}, damage[NUM_SPELLS] = {0};
+    int* lengths = (int*) malloc(sizeof(int) * tournament_matches);
+    for(int m = 0; m < tournament_matches; m++)
+    {
+        struct match_result* r = &match_results[m];
+        if(r->winner == -1) draws++;
+        else
+        {
+            wins[r->winner]++;
+            level_wins[r->level][r->winner]++;
+            winner_hp += r->winner_hp;
+        }
+        level_matches[r->level]++;
+        total_frames += r->frames;
+        if(lengths) lengths[m] = r->frames;
+        for(int s = 0; s < NUM_SPELLS; s++)
+        {
+            casts[s] += r->casts[s];
+            hits[s] += r->hits[s];
+            damage[s] += r->damage[s];
+        }
+    }
+
+    // Throughput, overall and for each thread (which should stay level as threads are added)
+    printf("Tournament: %d matches on %d thread%s in %.3f s (%lld frames, %.0f frames per second, %.0f per thread)\n",
+           tournament_matches, num_threads, num_threads == 1 ? "" : "s", seconds, total_frames, total_frames / fmax(seconds, 1e-9),
+           total_frames / fmax(seconds, 1e-9) / num_threads);
+    for(int t = 0; t < num_threads; t++)
+    {
+        printf("  Thread %d: %d matches, %lld frames\n", t, workers[t].matches, workers[t].frames);
+    }
+
+    // Win rates, overall and on each level
+    long long decided = wins[0] + wins[1];
+    printf("\nLeft guy wins:  %8lld", wins[0]);
+    printPercent(wins[0], tournament_matches);
+    printf("\nRight guy wins: %8lld", wins[1]);
+    printPercent(wins[1], tournament_matches);
+    printf("\nDraws:          %8lld", draws);
+    printPercent(draws, tournament_matches);
+    printf("   (no winner after %d frames)\n", MATCH_FRAME_LIMIT);
+    printf("Winner's health left: %.1f on average\n", decided ? (double) winner_hp / decided : 0.0);
+    for(int l = 0; l < NUM_FOREGROUNDS; l++)
+    {
+        printf("Level %d: %lld matches, left guy wins", l, level_matches[l]);
+        printPercent(level_wins[l][0], level_matches[l]);
+        printf(", right guy wins");
+        printPercent(level_wins[l][1], level_matches[l]);
+        printf("\n");
+    }
+
+    // Match lengths
+    if(lengths && tournament_matches)
+    {
+        qsort(lengths, tournament_matches, sizeof(int), compareFrames);
+        double mean = (double) total_frames / tournament_matches;
+        printf("\nMatch length (frames): mean %.0f (%.1f s), min %d, median %d, p90 %d, max %d\n",
+               mean, mean / MAX_FPS, lengths[0], lengths[tournament_matches / 2],
+               lengths[(int) (tournament_matches * 0.9)], lengths[tournament_matches - 1]);
+    }
+    free(lengths);
+
+    // What each spell did, per match and per cast
+    printf("\nSpell       Casts/match  Hits/match  Hit rate  Damage/match  Damage/cast  Share of damage\n");
+    long long all_damage = 0;
+    for(int s = 0; s < NUM_SPELLS; s++) all_damage += damage[s];
+    for(int s = 0; s < NUM_SPELLS; s++)
+    {
+        double n = tournament_matches ? tournament_matches : 1;
+        printf("%-10s %12.2f %11.2f   ", spell_names[s], casts[s] / n, hits[s] / n);
+        printPercent(hits[s], casts[s]);
+        printf(" %13.2f %12.2f          ", damage[s] / n, casts[s] ? (double) damage[s] / casts[s] : 0.0);
+        printPercent(damage[s], all_damage);
+        printf("\n");
+    }
+}
+
+/* TOURNAMENT */
+
+// Play a tournament on a pool of worker threads, and print a summary of the results
+bool runTournament(int num_matches, int num_threads, Uint64 seed)
+{
+    // One worker per core, the main thread being one of them
+    if(num_threads <= 0) num_threads = SDL_GetCPUCount();
+    if(num_threads > MAX_TOURNAMENT_THREADS) num_threads = MAX_TOURNAMENT_THREADS;
+    tournament_matches = num_matches;
+    tournament_seed = seed;
+    SDL_AtomicSet(&next_match, 0);
+
+    // Everything is allocated up front, so the workers never touch the heap
+    match_results = (struct match_result*) calloc(num_matches ? num_matches : 1, sizeof(struct match_result));
+    struct worker* workers = (struct worker*) calloc(num_threads, sizeof(struct worker));
+    bool ok = match_results && workers;
+    for(int t = 0; ok && t < num_threads; t++)
+    {
+        workers[t].world = newWorld(seed);
+        ok = workers[t].world != NULL;
+    }
+
+    if(ok)
+    {
+        // Start the other workers, then work on the main thread too (a worker that can't be started
+        // just leaves its share of the matches to the others)
+        Uint64 start = SDL_GetPerformanceCounter();
+        for(int t = 1; t < num_threads; t++)
+        {
+            workers[t].thread = SDL_CreateThread(workerThread, "tournament", &workers[t]);
+        }
+        workerThread(&workers[0]);
+        for(int t = 1; t < num_threads; t++)
+        {
+            if(workers[t].thread) SDL_WaitThread(workers[t].thread, NULL);
+        }
+        double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+        printSummary(workers, num_threads, seconds);
+    }
+
+    // Free the worlds and results
+    for(int t = 0; workers && t < num_threads; t++) freeWorld(workers[t].world);
+    free(workers);
+    free(match_results);
+    match_results = NULL;
+    return ok;
+}
@@ -0,0 +1,131 @@
+#include "../headers/constants.h"
+#include "../headers/trace.h"
+
+// Struct for one recorded event
+struct trace_event
+{
+    const char* name;           // name of the event (must be a string literal or otherwise outlive the trace)
+    Uint64 ticks;               // performance counter value when the event happened
+    char type;                  // 'B' for begin, 'E' for end
+};
+
+// Struct for a ring of events recorded by one thread
+struct trace_ring
+{
+    struct trace_event* events; // the ring's storage
+    Uint64 head;                // total number of events recorded (the next slot is head % capacity)
+    bool muted;                 // whether the thread's events are being dropped for now
+};
+
+bool tracing = false;                           // Whether events are being recorded
+const char* trace_path = NULL;                  // File the trace is written to
+struct trace_ring trace_rings[TRACE_THREADS];   // Ring of events for the main thread and for other threads
+SDL_threadID trace_main_thread;                 // Thread which started tracing
+Uint64 trace_start = 0;                         // Performance counter value when tracing started
+
+/* RECORDING */
+
+// Start tracing, writing the trace to path at exit
+bool initTrace(const char* path)
+{
+    for(int t = 0; t < TRACE_THREADS; t++)
+    {
+        trace_rings[t].events = (struct trace_event*) malloc(sizeof(struct trace_event) * TRACE_CAPACITY);
+        trace_rings[t].head = 0;
+        trace_rings[t].muted = false;
+        if(!trace_rings[t].events)
+        {
+            // Give back the rings allocated so far, so nothing is left pointing at them
+            for(int u = 0; u < t; u++)
+            {
+                free(trace_rings[u].events);
+                trace_rings[u].events = NULL;
+            }
+            return false;
+        }
+    }
+    trace_path = path;
+    trace_main_thread = SDL_ThreadID();
+    trace_start = SDL_GetPerformanceCounter();
+    tracing = true;
+    return true;
+}
+
+// Check whether events are being recorded
+bool isTracing()
+{
+    return tracing;
+}
+
+// Record an event which happened at a given performance counter value
+void traceEventAt(const char* name, char type, Uint64 ticks)
+{
+    if(!tracing) return;
+
+    // Each thread writes to its own ring, so recording needs no locks
+    struct trace_ring* ring = &trace_rings[SDL_ThreadID() != trace_main_thread];
+    if(ring->muted) return;
+    struct trace_event* e = &ring->events[ring->head++ & (TRACE_CAPACITY - 1)];
+    e->name = name;
+    e->ticks = ticks;
+    e->type = type;
+}
+
+// Record the beginning of a named event now
+void traceBegin(const char* name)
+{
+    if(tracing) traceEventAt(name, 'B', SDL_GetPerformanceCounter());
+}
+
+// Record the end of a named event now
+void traceEnd(const char* name)
+{
+    if(tracing) traceEventAt(name, 'E', SDL_GetPerformanceCounter());
+}
+
+// Drop (or stop dropping) the events the calling thread records
+void muteTrace(bool muted)
+{
+    if(tracing) trace_rings[SDL_ThreadID() != trace_main_thread].muted = muted;
+}
+
+/* OUTPUT */
+
+// Write the recorded events to the trace file as Chrome trace JSON, and stop tracing
+bool flushTrace()
+{
+    if(!tracing) return true;
+    tracing = false;
+
+    FILE* out = fopen(trace_path, "w");
+    bool written = out != NULL;
+    if(out)
+    {
+        double us_per_tick = 1000000.0 / SDL_GetPerformanceFrequency();
+        const char* separator = "";
+        fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for(int t = 0; t < TRACE_THREADS; t++)
+        {
+            // Only the newest TRACE_CAPACITY events of each thread are still in its ring
+            struct trace_ring* ring = &trace_rings[t];
+            Uint64 first = ring->head > TRACE_CAPACITY ? ring->head - TRACE_CAPACITY : 0;
+            for(Uint64 n = first; n < ring->head; n++)
+            {
+                struct trace_event* e = &ring->events[n & (TRACE_CAPACITY - 1)];
+                fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                        separator, e->name, e->type, (e->ticks - trace_start) * us_per_tick, t + 1);
+                separator = ",\n";
+            }
+        }
+        fprintf(out, "\n]}\n");
+        written = !ferror(out);
+        fclose(out);
+    }
+
+    for(int t = 0; t < TRACE_THREADS; t++)
+    {
+        free(trace_rings[t].events);
+        trace_rings[t].events = NULL;
+    }
+    return written;
+}
@@ -0,0 +1,180 @@
+#include "../headers/constants.h"
+#include "../headers/sprite.h"
+#include "../headers/broadphase.h"
+#include "../headers/particle.h"
+#include "../headers/level.h"
+#include "../headers/random.h"
+#include "../headers/cpu.h"
+#include "../headers/interface.h"
+#include "../headers/replay.h"
+#include "../headers/profiler.h"
+#include "../headers/trace.h"
+#include "../headers/world.h"
+
+/* WORLD CONSTRUCTOR */
+
+// Create a world at the start of the opening scene on the first level, with no sprites, and its scratch world
+World newWorld(Uint64 seed)
+{
+    // Worlds start out zeroed, which leaves the grid's cells empty as the broadphase expects
+    World w = (World) calloc(1, sizeof(struct world));
+    if(!w) return NULL;
+    w->lookahead = (World) calloc(1, sizeof(struct world));
+    if(!w->lookahead)
+    {
+        free(w);
+        return NULL;
+    }
+    w->lookahead->lookahead = NULL;
+    resetWorld(w, seed);
+    return w;
+}
+
+// Put a world back to the start of the opening scene on the first level, with no sprites
+void resetWorld(World w, Uint64 seed)
+{
+    // Everything not set below starts out zeroed (no particles, no statistics, empty sweep list), apart
+    // from the scratch space, which is rebuilt every frame anyway
+    memset(w, 0, SNAPSHOT_SIZE);
+    w->mode = OPENING;
+    initSpritePool(w);
+    w->particle_budget = 1;
+    switchLevel(w, FOREST);
+    resetBackgrounds(w);
+    seedRandom(&w->rng, seed);
+    for(int g = 0; g < 2; g++) w->plans[g].action = CPU_WAIT;
+}
+
+/* PER FRAME UPDATES */
+
+// Mark the end of a phase of a world's simulation for the profiler, if the world is being profiled
+static void markStep(bool profiled, int phase)
+{
+    if(profiled) markPhase(phase);
+}
+
+// Advance a world's simulation by one frame, returning which guy died (1 or 2) or 0
+static int step(World w, bool profiled)
+{
+    // Move the background
+    moveBackground(w);
+
+    // Update all particles, which only interact with terrain
+    updateParticles(w, getPlatforms(w), getWalls(w));
+    markStep(profiled, PHASE_PARTICLES);
+
+    // Update positions, velocities, and orientations of all sprites
+    moveSprites(w);
+    markStep(profiled, PHASE_MOVE);
+
+    // Check for and handle collisions with terrain or other sprites
+    terrainCollisions(w, getPlatforms(w), getWalls(w));
+    markStep(profiled, PHASE_TERRAIN);
+    spriteCollisions(w);
+    markStep(profiled, PHASE_COLLISIONS);
+
+    // Spawn any new spells that people are casting
+    launchSpells(w);
+    markStep(profiled, PHASE_LAUNCH);
+
+    // Update values on timed sprite variables (spell cooldowns, casting / collision durations, etc)
+    advanceTimers(w);
+    markStep(profiled, PHASE_TIMERS);
+
+    // Unload dead sprites and check for dead guys
+    int signal = unloadSprites(w);
+    markStep(profiled, PHASE_UNLOAD);
+
+    // Update the animation frame which is drawn for all sprites
+    updateAnimationFrames(w);
+    markStep(profiled, PHASE_ANIMATION);
+    return signal;
+}
+
+// Advance a world's simulation by one frame, returning which guy died (1 or 2) or 0
+int stepSimulation(World w)
+{
+    return step(w, true);
+}
+
+// Advance a world's simulation by one frame without profiling or tracing it
+int stepLookahead(World w)
+{
+    muteTrace(true);
+    int signal = step(w, false);
+    muteTrace(false);
+    return signal;
+}
+
+/* SCORE */
+
+// Reset the score
+void setScore(World w, int new_score)
+{
+    w->score = new_score;
+}
+
+// Add points to the score
+void updateScore(World w, int points)
+{
+    w->score += points;
+}
+
+// Get the score
+int getScore(World w)
+{
+    return w->score;
+}
+
+/* GETTERS */
+
+// Hash everything in a world that affects gameplay (particles and the cosmetic random stream are
+// left out, since the particle budget makes them differ from run to run)
+Uint64 hashWorld(World w)
+{
+    int level = getLevel(w);
+    Uint64 hash = HASH_START;
+    hash = hashBytes(hash, &w->mode, sizeof(int));
+    hash = hashBytes(hash, &w->frame, sizeof(long long));
+    hash = hashBytes(hash, &level, sizeof(int));
+    hash = hashBytes(hash, &w->score, sizeof(int));
+    hash = hashSprites(w, hash);
+    return hashRandom(&w->rng, hash);
+}
+
+/* SNAPSHOTS */
+
+// Save everything in a world into a buffer of SNAPSHOT_SIZE bytes
+void saveWorld(World w, void* snapshot)
+{
+    memcpy(snapshot, w, SNAPSHOT_SIZE);
+}
+
+// Restore a world from a snapshot (the scratch space is left as is, since every frame rebuilds it)
+void restoreWorld(World w, const void* snapshot)
+{
+    memcpy(w, snapshot, SNAPSHOT_SIZE);
+}
+
+// Make one world an exact copy of another
+void copyWorld(World dst, World src)
+{
+    if(dst != src) memcpy(dst, src, SNAPSHOT_SIZE);
+}
+
+// Make one world a copy of another's gameplay, leaving out the particle rings, which are most of a world
+void copyGameplay(World dst, World src)
+{
+    if(dst != src) memcpy(dst, src, GAMEPLAY_SIZE);
+    turnOffParticles(dst);
+}
+
+/* DATA UNLOADING */
+
+// Free a world and everything in it (nothing happens for NULL, like free)
+void freeWorld(World w)
+{
+    if(!w) return;
+    freeWorld(w->lookahead);
+    free(w);
+}